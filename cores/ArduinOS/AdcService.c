@@ -0,0 +1,396 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+#include <string.h>
+
+#include "wiring_private.h"
+#include "AdcService.h"
+
+#if (CONFIG_USE_ADC_SERVICE == 1) && defined(ADCSRA) && defined(ADCL)
+
+// ADCを使用するタスクを1つにする. スキャン中はスキャンを開始したタスクが持ち続ける.
+static SemaphoreHandle adcLock = NULL;
+
+// 変換の終わり, スキャンの蓄積を待っているタスクを起こす.
+static SemaphoreHandle adcDone = NULL;
+
+// 単発の変換
+static volatile uint16_t conversionResult;
+static volatile uint8_t conversionDone;
+static volatile uint8_t conversionWaiting = 0;
+
+// スキャン
+static volatile uint8_t scanActive = 0;
+static uint8_t scanPins[ADC_SCAN_MAX_PINS];
+static uint8_t scanPinCount;
+static uint8_t scanPinIndex;
+
+// リングバッファ. スキャン単位で管理する.
+// 割り込みはhead, タスクはtailのスキャンだけを書き換える.
+static uint16_t *scanBuffer = NULL;
+static unsigned short scanCapacity;
+static unsigned short scanHead;
+static unsigned short scanTail;
+static volatile unsigned short scanStored;
+
+// 現在のスキャンをバッファに書き込んでいるか. バッファがいっぱいのときは捨てる.
+static uint8_t scanWriting;
+static volatile unsigned short scanWanted = 0;
+static volatile unsigned short scanOverrunCount = 0;
+
+// スキャン前のTimer1の設定
+static uint8_t savedTCCR1A, savedTCCR1B, savedTIMSK1;
+static uint16_t savedOCR1A, savedOCR1B;
+
+void AdcServiceInit(void)
+{
+    SemaphoreCreateBinary(adcLock);
+    SemaphoreCreateBinary(adcDone);
+}
+
+ISR_WAKING_TASK(ADC_vect)
+{
+    uint8_t low, high;
+    uint16_t value;
+    signed PortBaseType higherPriorityTaskWoken = PD_FALSE;
+
+    // ADCLを先に読む.
+    low = ADCL;
+    high = ADCH;
+    value = (high << 8) | low;
+
+    if (scanActive)
+    {
+        // 次のコンペアマッチで変換を開始できるようにフラグを消す.
+        TIFR1 = _BV(OCF1B);
+
+        if (scanWriting)
+        {
+            scanBuffer[scanHead * scanPinCount + scanPinIndex] = value;
+        }
+
+        if (++scanPinIndex >= scanPinCount)
+        {
+            scanPinIndex = 0;
+
+            if (scanWriting)
+            {
+                if (++scanHead >= scanCapacity)
+                {
+                    scanHead = 0;
+                }
+                scanStored++;
+
+                if ((scanWanted != 0) && (scanStored >= scanWanted))
+                {
+                    scanWanted = 0;
+                    SemaphoreGiveFromISR(adcDone, &higherPriorityTaskWoken);
+                }
+            }
+
+            scanWriting = (scanStored < scanCapacity);
+            if (!scanWriting && (scanOverrunCount != 0xffff))
+            {
+                scanOverrunCount++;
+            }
+        }
+
+        // 次のトリガーで変換するピン
+        analogSelectChannel(scanPins[scanPinIndex]);
+    }
+    else
+    {
+        conversionResult = value;
+        conversionDone = 1;
+
+        if (conversionWaiting)
+        {
+            conversionWaiting = 0;
+            SemaphoreGiveFromISR(adcDone, &higherPriorityTaskWoken);
+        }
+    }
+
+    YieldFromISR(higherPriorityTaskWoken);
+}
+
+int AdcRead(uint8_t pin)
+{
+    uint8_t channel = analogPinToAdcChannel(pin);
+    int value;
+
+    if ((adcLock == NULL) || (adcDone == NULL) || !taskCanBlock())
+    {
+        // スキャン中は変換の終わりを割り込みが受け取ってしまう.
+        return scanActive ? -1 : analogReadChannelPolling(channel);
+    }
+
+    while (SemaphoreTake(adcLock, PORT_MAX_DELAY) != PD_TRUE);
+
+    analogSelectChannel(channel);
+
+    EnterCritical();
+    {
+        conversionDone = 0;
+        conversionWaiting = 1;
+
+        // 前の変換で残ったフラグを消してから, 割り込みを許可して変換を開始する.
+        ADCSRA |= _BV(ADIF) | _BV(ADIE) | _BV(ADSC);
+    }
+    ExitCritical();
+
+    // 変換は1tickより十分短いため, 以前の変換で与えられたセマフォで起きても,
+    // conversionDoneを確認して待ち直せばよい.
+    while (!conversionDone)
+    {
+        SemaphoreTake(adcDone, 2);
+    }
+
+    cbi(ADCSRA, ADIE);
+    conversionWaiting = 0;
+    value = conversionResult;
+
+    SemaphoreGive(adcLock);
+
+    return value;
+}
+
+signed PortBaseType AdcScanStart(const uint8_t *pins, uint8_t pinCount, unsigned long scanRateHz, unsigned short bufferScans)
+{
+#if !defined(OCR1B) || !defined(ADATE)
+    // 変換の自動開始ができない.
+    (void)pins; (void)pinCount; (void)scanRateHz; (void)bufferScans;
+    return PD_FAIL;
+#else
+    unsigned long triggerRateHz, cycles;
+    unsigned long maxRateHz;
+    uint8_t adcPrescalerBits;
+    uint8_t clockSelect;
+    uint16_t prescaler;
+    uint8_t i;
+
+    if ((adcLock == NULL) || (adcDone == NULL) || (pinCount == 0) || (pinCount > ADC_SCAN_MAX_PINS) ||
+        (scanRateHz == 0) || (bufferScans == 0))
+    {
+        return PD_FAIL;
+    }
+
+    // 1回の変換には13クロックかかる. ADCのクロックはADPSで分周される(0は2分周).
+    adcPrescalerBits = ADCSRA & (_BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0));
+    maxRateHz = (F_CPU / ((adcPrescalerBits == 0) ? 2UL : (1UL << adcPrescalerBits))) / 13UL;
+    triggerRateHz = scanRateHz * pinCount;
+    if (triggerRateHz > maxRateHz)
+    {
+        return PD_FAIL;
+    }
+
+    // Timer1の分周を, 比較値が16bitに収まる最小のものにする.
+    cycles = F_CPU / triggerRateHz;
+    if (cycles <= 0x10000UL)
+    {
+        prescaler = 1; clockSelect = _BV(CS10);
+    }
+    else if (cycles <= 0x10000UL * 8UL)
+    {
+        prescaler = 8; clockSelect = _BV(CS11);
+    }
+    else if (cycles <= 0x10000UL * 64UL)
+    {
+        prescaler = 64; clockSelect = _BV(CS11) | _BV(CS10);
+    }
+    else if (cycles <= 0x10000UL * 256UL)
+    {
+        prescaler = 256; clockSelect = _BV(CS12);
+    }
+    else if (cycles <= 0x10000UL * 1024UL)
+    {
+        prescaler = 1024; clockSelect = _BV(CS12) | _BV(CS10);
+    }
+    else
+    {
+        return PD_FAIL;
+    }
+
+    // スキャン中はADCを持ち続ける.
+    if (SemaphoreTake(adcLock, 0) != PD_TRUE)
+    {
+        return PD_FAIL;
+    }
+
+    // Timer1がtickやパルス測定などに使われているときは失敗する.
+    if (TimerAcquire(1, TIMER_OWNER_ADC_SCAN) != PD_PASS)
+    {
+        SemaphoreGive(adcLock);
+        return PD_FAIL;
+    }
+
+    scanBuffer = (uint16_t *)PortMalloc(sizeof(uint16_t) * pinCount * bufferScans);
+    if (scanBuffer == NULL)
+    {
+        TimerRelease(1, TIMER_OWNER_ADC_SCAN);
+        SemaphoreGive(adcLock);
+        return PD_FAIL;
+    }
+
+    for (i = 0; i < pinCount; i++)
+    {
+        scanPins[i] = analogPinToAdcChannel(pins[i]);
+    }
+    scanPinCount = pinCount;
+    scanPinIndex = 0;
+    scanCapacity = bufferScans;
+    scanHead = 0;
+    scanTail = 0;
+    scanStored = 0;
+    scanWriting = 1;
+    scanWanted = 0;
+    scanOverrunCount = 0;
+
+    EnterCritical();
+    {
+        savedTCCR1A = TCCR1A;
+        savedTCCR1B = TCCR1B;
+        savedTIMSK1 = TIMSK1;
+        savedOCR1A = OCR1A;
+        savedOCR1B = OCR1B;
+
+        // Timer1: CTC(TOP = OCR1A). コンペアマッチBでADCの変換を開始する.
+        TIMSK1 = 0;
+        TCCR1B = 0;
+        TCCR1A = 0;
+        TCNT1 = 0;
+        OCR1A = (uint16_t)((cycles / prescaler) - 1);
+        OCR1B = OCR1A;
+        TIFR1 = _BV(OCF1B);
+
+        analogSelectChannel(scanPins[0]);
+        scanActive = 1;
+
+        // 変換の自動開始元: Timer1 コンペアマッチB
+        ADCSRB = (ADCSRB & ~(_BV(ADTS2) | _BV(ADTS1) | _BV(ADTS0))) | _BV(ADTS2) | _BV(ADTS0);
+        ADCSRA |= _BV(ADIF) | _BV(ADIE) | _BV(ADATE);
+
+        TCCR1B = _BV(WGM12) | clockSelect;
+    }
+    ExitCritical();
+
+    return PD_PASS;
+#endif
+}
+
+void AdcScanStop(void)
+{
+    if (!scanActive)
+    {
+        return;
+    }
+
+    EnterCritical();
+    {
+        ADCSRA &= ~(_BV(ADIE) | _BV(ADATE));
+        scanActive = 0;
+
+        TCCR1B = 0;
+        TCCR1A = savedTCCR1A;
+        OCR1A = savedOCR1A;
+        OCR1B = savedOCR1B;
+        TIMSK1 = savedTIMSK1;
+        TCCR1B = savedTCCR1B;
+    }
+    ExitCritical();
+
+    TimerRelease(1, TIMER_OWNER_ADC_SCAN);
+
+    // 変換中だった場合は終わるのを待つ.
+    while (bit_is_set(ADCSRA, ADSC));
+
+    PortFree(scanBuffer);
+    scanBuffer = NULL;
+
+    SemaphoreGive(adcLock);
+}
+
+unsigned short AdcScanRead(uint16_t *samples, unsigned short scans, PortTickType ticksToWait)
+{
+    TimeOutType timeOut;
+    unsigned short available;
+    unsigned short count;
+    unsigned short copied = 0;
+
+    if (!scanActive || (scans == 0))
+    {
+        return 0;
+    }
+
+    if (scans > scanCapacity)
+    {
+        scans = scanCapacity;
+    }
+
+    TaskSetTimeOutState(&timeOut);
+    for (;;)
+    {
+        EnterCritical();
+        {
+            available = scanStored;
+            // 割り込みに起こしてもらうため, 確認と同時に待っていることを知らせる.
+            scanWanted = (available < scans) ? scans : 0;
+        }
+        ExitCritical();
+
+        if ((available >= scans) || (TaskCheckForTimeOut(&timeOut, &ticksToWait) != PD_FALSE))
+        {
+            break;
+        }
+        SemaphoreTake(adcDone, ticksToWait);
+    }
+    scanWanted = 0;
+
+    if (available > scans)
+    {
+        available = scans;
+    }
+
+    // tailから順にコピーする. 割り込みはこの範囲を書き換えない.
+    while (copied < available)
+    {
+        count = available - copied;
+        if (count > (scanCapacity - scanTail))
+        {
+            count = scanCapacity - scanTail;
+        }
+
+        memcpy(&samples[copied * scanPinCount], &scanBuffer[scanTail * scanPinCount],
+            sizeof(uint16_t) * scanPinCount * count);
+
+        copied += count;
+        scanTail += count;
+        if (scanTail >= scanCapacity)
+        {
+            scanTail = 0;
+        }
+    }
+
+    EnterCritical();
+    {
+        scanStored -= available;
+    }
+    ExitCritical();
+
+    return available;
+}
+
+unsigned short AdcScanGetOverrunCount(void)
+{
+    return scanOverrunCount;
+}
+
+#endif
@@ -0,0 +1,143 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+
+/*
+// ADCサービス
+//
+// CONFIG_USE_ADC_SERVICE が1のとき, ADCの変換を割り込み(ADC_vect)で扱います.
+//
+// 単発の変換:
+//  analogRead()とAdcRead()は変換が終わるまで呼び出したタスクをブロックします.
+//  変換中(約104us)は他のタスクが実行されます.
+//  割り込み関数の中, 割り込み禁止中とsetup()の中では, 従来通り変換の終わりを待ち続けます.
+//
+// スキャン:
+//  AdcScanStart()で指定したピンを指定した周期で順に変換し, リングバッファに溜めます.
+//  変換の開始はTimer1のコンペアマッチBで行われるため, スキャン中はTimer1を使用できません
+//  (9, 10番ピンのanalogWrite(), Servoライブラリなど).
+//  Timer1がtickやパルス測定など, 他に使用されているとき(TimerManager.h)はスキャンできません.
+//  タスクはAdcScanRead()で, 溜まったサンプルをスキャン単位でまとめて受け取ります.
+//
+// スキャン中にAdcRead()を呼んだタスクは, スキャンが停止するまで待ちます.
+// スキャンを開始したタスクからは, スキャン中にAdcRead()を呼ばないでください.
+*/
+
+#ifndef ADC_SERVICE_H
+#define ADC_SERVICE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (CONFIG_USE_ADC_SERVICE == 1)
+
+    /*
+    // 指定したピンの電圧を読み取ります. analogRead()から呼ばれます.
+    //
+    // @param pin:
+    //  A0などのピン番号, またはチャンネル番号.
+    //
+    // @return:
+    //  0 から 1023 までの変換結果.
+    //  ブロックできない状態(割り込み関数の中など)でスキャン中のときは -1.
+    */
+    int AdcRead(uint8_t pin);
+
+    /*
+    // スキャンを開始します.
+    // 1回のスキャンで, pinsのピンを順に1回ずつ変換します.
+    //
+    // @param pins:
+    //  変換するピン. 内容はコピーされます.
+    //
+    // @param pinCount:
+    //  ピンの数. 1 から ADC_SCAN_MAX_PINS まで.
+    //
+    // @param scanRateHz:
+    //  1秒あたりのスキャン回数.
+    //  scanRateHz * pinCount はADCの変換速度(16Mhzでは約9600回/s)以下にしてください.
+    //
+    // @param bufferScans:
+    //  リングバッファに溜めておけるスキャンの数.
+    //  バッファはPortMalloc()で確保され, sizeof(uint16_t) * pinCount * bufferScans byteを使用します.
+    //
+    // @return:
+    //  PD_PASS if the scan was started, otherwise PD_FAIL.
+    //
+    // Example usage:
+
+    const uint8_t pins[] = {A0, A1};
+    uint16_t samples[2 * 50];
+
+    TaskLoop(sampleTask)
+    {
+        // 1kHzで2ピンをスキャンし, 50スキャン(50ms)ごとに処理する.
+        if (AdcScanStart(pins, 2, 1000, 200) == PD_PASS)
+        {
+            for (;;)
+            {
+                unsigned short scans = AdcScanRead(samples, 50, PORT_MAX_DELAY);
+
+                // samples[2 * i]がA0, samples[2 * i + 1]がA1のi番目のサンプル.
+                // ...
+            }
+        }
+    }
+    */
+    signed PortBaseType AdcScanStart(const uint8_t *pins, uint8_t pinCount, unsigned long scanRateHz, unsigned short bufferScans);
+
+    /*
+    // スキャンを停止し, バッファを開放します.
+    // Timer1の設定はAdcScanStart()を呼ぶ前の状態に戻ります.
+    */
+    void AdcScanStop(void);
+
+    /*
+    // 溜まったサンプルを受け取ります.
+    // scans回分のスキャンが溜まるか, タイムアウトするまでタスクをブロックします.
+    //
+    // @param samples:
+    //  サンプルのコピー先. pinCount * scans個の要素が必要です.
+    //  スキャンごとに, AdcScanStart()のpinsの順にサンプルが並びます.
+    //
+    // @param scans:
+    //  受け取るスキャンの数. bufferScansより大きいときはbufferScansになります.
+    //
+    // @param ticksToWait:
+    //  待つ最大のtick数.
+    //
+    // @return:
+    //  受け取ったスキャンの数. タイムアウトした場合はscansより少なくなります.
+    */
+    unsigned short AdcScanRead(uint16_t *samples, unsigned short scans, PortTickType ticksToWait);
+
+    /*
+    // バッファがいっぱいで捨てられたスキャンの数を返します.
+    */
+    unsigned short AdcScanGetOverrunCount(void);
+
+    // AdcScanStart()で指定できるピンの最大数
+#define ADC_SCAN_MAX_PINS 8
+
+    // init()から呼ばれる.
+    void AdcServiceInit(void);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
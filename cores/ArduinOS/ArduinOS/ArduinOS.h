@@ -47,6 +47,29 @@
 //    CONFIG_IDLE_SHOULD_YIELD(1)
 //    CONFIG_MAX_TASK_NAME_LEN(16)
 //    CONFIG_CHECK_FOR_STACK_OVERFLOW(1)
+//    CONFIG_USE_QUEUE_STATS(0)
+//    CONFIG_USE_PRIORITY_QUEUES(0)
+//    CONFIG_MAX_MESSAGE_PRIORITIES(4)
+//    CONFIG_USE_PRIORITY_CEILING_MUTEXES(0)
+//    CONFIG_TICK_SOURCE(PORT_TICK_SOURCE_TIMER0)
+//    CONFIG_USE_ISR_STACK(0)
+//    CONFIG_ISR_STACK_SIZE(128)
+//    CONFIG_USE_ISR_YIELD(0)
+//    CONFIG_USE_TASK_DELAY_IN_DELAY(1)
+//    CONFIG_USE_TASK_BLOCKING_SERIAL(1)
+//    CONFIG_USE_SERIAL_MUTEX(0)
+//    CONFIG_USE_SERIAL_EVENT_TASK(0)
+//    CONFIG_SERIAL_EVENT_PRIORITY(NORMAL_PRIORITY)
+//    CONFIG_SERIAL_EVENT_STACK_SIZE(CONFIG_MINIMAL_STACK_SIZE)
+//    CONFIG_USE_ADC_SERVICE(0)
+//    CONFIG_USE_PULSE_SERVICE(0)
+//    CONFIG_USE_PIN_CHANGE_INTERRUPTS(CONFIG_USE_PULSE_SERVICE)
+//    CONFIG_PIN_CHANGE_MAX_PINS(8)
+//    CONFIG_USE_DEFERRED_INTERRUPTS(0)
+//    CONFIG_DEFERRED_INTERRUPT_PRIORITY(CONFIG_MAX_PRIORITIES - 1)
+//    CONFIG_DEFERRED_INTERRUPT_STACK_SIZE(CONFIG_MINIMAL_STACK_SIZE)
+//    CONFIG_USE_CRITICAL_PROFILER(0)
+//    CONFIG_CRITICAL_PROFILER_SITES(8)
 //    INCLUDE_TASK_GET_STATE(0)
 //    INCLUDE_TASK_GET_SCHEDULER_STATE(0)
 //    INCLUDE_TASK_GET_CURRENT_TASK_HANDLE(0)
@@ -70,6 +93,8 @@
 //  Portable.h
 //  PortMacro.h
 //
+//  ARDUINOS_PORT_POSIXを定義すると, Posix/以下のLinuxホスト用ポートが使用される.
+//
 //  AVRマイコン以外のマイコンを使用する際, 特に,
 //  ハードウェア構造がAVRマイコンと異なる場合は,
 //  これらファイルを変更する必要がある.
@@ -346,6 +371,173 @@ typedef PortBaseType(*TaskHookCode)(void *);
     #define CONFIG_CHECK_FOR_STACK_OVERFLOW 0
 #endif
 
+#ifndef CONFIG_USE_QUEUE_STATS
+    // Queueごとの統計情報(最大格納数, 満杯/空の回数, 待機回数, 待機時間)を記録します.
+    // 記録された値はQueueGetStats()で取得できます.
+    // 作成されたQueueはすべてレジストリに登録され, QueueGetNextRegistered()で列挙できます.
+    //
+    // 0: 記録しない
+    // 1: 記録する
+    #define CONFIG_USE_QUEUE_STATS 0
+#endif
+
+#ifndef CONFIG_USE_PRIORITY_QUEUES
+    // 優先度付きQueue(QueuePriorityCreate())を使用するか.
+    // 使用する場合, すべてのQueueに索引へのポインタ分のメモリが追加されます.
+    #define CONFIG_USE_PRIORITY_QUEUES 0
+#endif
+
+#ifndef CONFIG_MAX_MESSAGE_PRIORITIES
+    // 優先度付きQueueで使用できるメッセージ優先度の数.
+    // 優先度は 0 から CONFIG_MAX_MESSAGE_PRIORITIES - 1 まで.
+    #define CONFIG_MAX_MESSAGE_PRIORITIES 4
+#endif
+
+#ifndef CONFIG_USE_PRIORITY_CEILING_MUTEXES
+    // 優先度上限プロトコルのMutex(SemaphoreCreateCeilingMutex())を使用するか.
+    // CONFIG_USE_MUTEXES が1である必要があります.
+    #define CONFIG_USE_PRIORITY_CEILING_MUTEXES 0
+#endif
+
+#if (CONFIG_USE_PRIORITY_CEILING_MUTEXES == 1) && (CONFIG_USE_MUTEXES != 1)
+    #error CONFIG_USE_PRIORITY_CEILING_MUTEXES requires CONFIG_USE_MUTEXES to be 1.
+#endif
+
+#ifndef CONFIG_TICK_SOURCE
+    // tick割り込みに使用するタイマー. 詳しくはPortMacro.hを参照してください.
+    //
+    // PORT_TICK_SOURCE_TIMER0: Timer0のオーバーフロー(約976Hz, CONFIG_TICK_RATE_HZとは一致しない)
+    // PORT_TICK_SOURCE_TIMER1: Timer1のCTC. CONFIG_TICK_RATE_HZ通りの正確なtick
+    // PORT_TICK_SOURCE_TIMER2: Timer2のCTC. CONFIG_TICK_RATE_HZ通りの正確なtick
+    //
+    // Timer1, Timer2を使用する場合, millis()とmicros()を正確に保つため,
+    // CONFIG_TICK_RATE_HZは1000000の約数(500, 1000, 2000, 4000, 5000など)にしてください.
+    #define CONFIG_TICK_SOURCE PORT_TICK_SOURCE_TIMER0
+#endif
+
+#ifndef CONFIG_USE_ISR_STACK
+    // 割り込み処理を専用のスタックで実行するか.
+    // tick割り込みでのカーネルの処理と, ISR_ON_ISR_STACK()で宣言した割り込み関数が
+    // 専用のスタックで実行されるため, 各タスクのスタックに割り込み分の余裕を持たせる必要が減ります.
+    // タスクのスタックには, 保存されるコンテキストだけが積まれます.
+    #define CONFIG_USE_ISR_STACK 0
+#endif
+
+#ifndef CONFIG_ISR_STACK_SIZE
+    // 割り込み専用スタックのサイズ(byte). CONFIG_USE_ISR_STACKが1のときに使用されます.
+    #define CONFIG_ISR_STACK_SIZE 128
+#endif
+
+#ifndef CONFIG_USE_ISR_YIELD
+    // attachInterrupt()で登録した関数からYieldFromISR()を使用できるようにするか.
+    // 1のとき, 外部割り込みとHardwareSerialの割り込みはISR_WITH_YIELD()で宣言され,
+    // 受信を待っていたタスクなどへ割り込みの終わりで直接切り替わります.
+    // 割り込みのたびにすべてのレジスタが保存されるため, 割り込みの処理時間は長くなります.
+    #define CONFIG_USE_ISR_YIELD 0
+#endif
+
+#ifndef CONFIG_USE_TASK_DELAY_IN_DELAY
+    // delay()でTaskDelay()を使用し, 待っている間に他のタスクを実行するか.
+    // 1のとき, yield()はTaskYield()を呼びます.
+    // スケジューラが動作していないとき(setup()の中など)や割り込み禁止中は, 従来通り待ち続けます.
+    #define CONFIG_USE_TASK_DELAY_IN_DELAY 1
+#endif
+
+#ifndef CONFIG_USE_TASK_BLOCKING_SERIAL
+    // HardwareSerialの送信バッファの空き待ちと, タイムアウト付きの受信待ち(readBytes()など)で,
+    // タスクをブロックするか. 待っている間, 優先度の低いタスクが実行されます.
+    // シリアルポートごとにbegin()でセマフォが2つ作成されます.
+    #define CONFIG_USE_TASK_BLOCKING_SERIAL 1
+#endif
+
+#ifndef CONFIG_USE_SERIAL_MUTEX
+    // HardwareSerialの送信をMutexで排他するか. 複数のタスクが同じシリアルポートに出力しても,
+    // 1回のwrite(), print()の途中で他のタスクの出力が混ざらなくなります.
+    // 複数のprint()を1行としてまとめるにはSerialLockを使用してください.
+    // シリアルポートごとにbegin()で優先度継承のMutexが1つ作成されます.
+    // CONFIG_USE_MUTEXES が1である必要があります.
+    #define CONFIG_USE_SERIAL_MUTEX 0
+#endif
+
+#if (CONFIG_USE_SERIAL_MUTEX == 1) && (CONFIG_USE_MUTEXES != 1)
+    #error CONFIG_USE_SERIAL_MUTEX requires CONFIG_USE_MUTEXES to be 1.
+#endif
+
+#ifndef CONFIG_USE_SERIAL_EVENT_TASK
+    // serialEvent()をloop()の後で毎回確認するのではなく, 受信割り込みに起こされるタスクから呼ぶか.
+    // loop()がブロックしていてもserialEvent()が呼ばれます. 呼ぶ条件はsetEventTrigger()で変更できます.
+    // serialEvent()が定義されているときだけ, setup()の後でタスクとセマフォが作成されます.
+    // serialEvent()はloop()とは別のタスクで, loop()の途中にも実行されます. 標準のサンプルの
+    // inputStringのようにloop()と共有する変数は, 読み書きをEnterCritical()やミューテックスで
+    // 保護してください.
+    #define CONFIG_USE_SERIAL_EVENT_TASK 0
+#endif
+
+#ifndef CONFIG_SERIAL_EVENT_PRIORITY
+    // serialEvent()を呼ぶタスクの優先度.
+    #define CONFIG_SERIAL_EVENT_PRIORITY (NORMAL_PRIORITY)
+#endif
+
+#ifndef CONFIG_SERIAL_EVENT_STACK_SIZE
+    // serialEvent()を呼ぶタスクのスタックサイズ. serialEvent()はすべてこのスタックで実行されます.
+    #define CONFIG_SERIAL_EVENT_STACK_SIZE (CONFIG_MINIMAL_STACK_SIZE)
+#endif
+
+#ifndef CONFIG_USE_ADC_SERVICE
+    // ADCの変換を割り込みで扱い, analogRead()で変換中にタスクをブロックするか.
+    // 複数のピンを一定の周期で変換し続けるスキャンも使用できます. 詳しくはAdcService.hを参照してください.
+    // ADC_vectを使用するため, 他のライブラリの割り込み関数と衝突する場合は0にしてください.
+    #define CONFIG_USE_ADC_SERVICE 0
+#endif
+
+#ifndef CONFIG_USE_PULSE_SERVICE
+    // パルスの幅と周期を, Timer1のインプットキャプチャとピン変化割り込みで測定するか.
+    // 測定を待つタスクはブロックされます. 詳しくはPulseService.hを参照してください.
+    // TIMER1_CAPT_vect, TIMER1_OVF_vectを使用するため, 他のライブラリの割り込み関数と
+    // 衝突する場合は0にしてください.
+    #define CONFIG_USE_PULSE_SERVICE 0
+#endif
+
+#ifndef CONFIG_USE_PIN_CHANGE_INTERRUPTS
+    // ピン変化割り込み(PCINT)をピンごとに使用するか. 詳しくはPinChangeInterrupt.hを参照してください.
+    // PCINTn_vectを使用するため, SoftwareSerialなどと衝突する場合は0にしてください.
+    // パルス測定サービスは, 0のときICP1のピンだけを測定できます.
+    #define CONFIG_USE_PIN_CHANGE_INTERRUPTS CONFIG_USE_PULSE_SERVICE
+#endif
+
+#ifndef CONFIG_PIN_CHANGE_MAX_PINS
+    // ピン変化割り込みに同時に登録できるピンの最大数. 1つにつき11byteを使用します.
+    #define CONFIG_PIN_CHANGE_MAX_PINS 8
+#endif
+
+#ifndef CONFIG_USE_DEFERRED_INTERRUPTS
+    // attachInterruptDeferred()を使用するか.
+    // 外部割り込みの処理を, 割り込み関数ではなく割り込み処理タスクの中で行います.
+    // 最初にattachInterruptDeferred()を呼んだときに, 割り込み処理タスクとセマフォが作成されます.
+    #define CONFIG_USE_DEFERRED_INTERRUPTS 0
+#endif
+
+#ifndef CONFIG_DEFERRED_INTERRUPT_PRIORITY
+    // 割り込み処理タスクの優先度.
+    #define CONFIG_DEFERRED_INTERRUPT_PRIORITY (CONFIG_MAX_PRIORITIES - 1)
+#endif
+
+#ifndef CONFIG_DEFERRED_INTERRUPT_STACK_SIZE
+    // 割り込み処理タスクのスタックサイズ. 登録した関数はすべてこのスタックで実行されます.
+    #define CONFIG_DEFERRED_INTERRUPT_STACK_SIZE (CONFIG_MINIMAL_STACK_SIZE)
+#endif
+
+#ifndef CONFIG_USE_CRITICAL_PROFILER
+    // クリティカルセクションごとの割り込み禁止時間を測定するか. 詳しくはCriticalProfiler.hを参照してください.
+    // PortMacro.hで使用されるため, 有効にする場合はArduinOSConfig.hで定義してください.
+    #define CONFIG_USE_CRITICAL_PROFILER 0
+#endif
+
+#ifndef CONFIG_CRITICAL_PROFILER_SITES
+    // 記録するクリティカルセクション(ファイルと行)の最大数.
+    #define CONFIG_CRITICAL_PROFILER_SITES 8
+#endif
+
 // End Config系 ---------------------------------------------------
 
 // --- Include系 -----------------------------------------------------
@@ -354,6 +546,7 @@ typedef PortBaseType(*TaskHookCode)(void *);
     #define INCLUDE_TASK_GET_STATE 0
 #endif
 
+// TaskGetSchedulerState()はコアのライブラリが使用するため常にビルドされる. この設定は互換性のために残している.
 #ifndef INCLUDE_TASK_GET_SCHEDULER_STATE
     #define INCLUDE_TASK_GET_SCHEDULER_STATE 0
 #endif
@@ -376,6 +569,76 @@ typedef PortBaseType(*TaskHookCode)(void *);
     #define PortYieldWithinAPI() PortYield()
 #endif
 
+/*
+// カーネル以外の割り込み関数を宣言します.
+// CONFIG_USE_ISR_STACKが1のとき, 割り込み関数は割り込み専用のスタックで実行されます.
+// 0のとき, ISR()と同じです.
+//
+// 割り込み関数の中で割り込みを許可(sei())しないでください.
+//
+// Example usage:
+
+ISR_ON_ISR_STACK(USART_RX_vect)
+{
+    Serial._rx_complete_irq();
+}
+*/
+#if (CONFIG_USE_ISR_STACK == 1) && defined(PORT_ISR_ON_ISR_STACK)
+    #define ISR_ON_ISR_STACK(vector) PORT_ISR_ON_ISR_STACK(vector)
+#else
+    #define ISR_ON_ISR_STACK(vector) ISR(vector)
+#endif
+
+/*
+// 割り込みの終わりでコンテキストスイッチができる割り込み関数を宣言します.
+// 割り込み関数の中でYieldFromISR()を呼ぶと, 割り込みから戻るときに
+// 起床したタスクへ直接切り替わります. 次のtickまで待つ必要はありません.
+//
+// 入口ですべてのレジスタを保存するため, ISR()より処理時間は長くなります.
+// CONFIG_USE_ISR_STACKが1のとき, 割り込み関数は割り込み専用のスタックで実行されます.
+//
+// 割り込み関数の中で割り込みを許可(sei())しないでください.
+//
+// Example usage:
+
+ISR_WITH_YIELD(INT0_vect)
+{
+    signed PortBaseType higherPriorityTaskWoken = PD_FALSE;
+
+    SemaphoreGiveFromISR(semaphore, &higherPriorityTaskWoken);
+    YieldFromISR(higherPriorityTaskWoken);
+}
+*/
+#if defined(PORT_ISR_WITH_YIELD)
+    #define ISR_WITH_YIELD(vector) PORT_ISR_WITH_YIELD(vector)
+#else
+    #define ISR_WITH_YIELD(vector) ISR(vector)
+#endif
+
+/*
+// ISR_WITH_YIELD()で宣言した割り込み関数の中で使用します.
+// switchRequiredがPD_FALSEでないとき, 割り込みから戻るときにコンテキストスイッチを行います.
+//
+// @param switchRequired:
+//  ...FromISR()関数のhigherPriorityTaskWoken, またはTaskResumeFromISR()の戻り値.
+*/
+#if defined(PortYieldFromISR)
+    #define YieldFromISR(switchRequired) PortYieldFromISR(switchRequired)
+#else
+    #define YieldFromISR(switchRequired) ((void)(switchRequired))
+#endif
+
+/*
+// 待っているタスクを起こす割り込み関数を宣言します.
+// CONFIG_USE_ISR_YIELDが1のときISR_WITH_YIELD(), 0のときISR_ON_ISR_STACK()と同じです.
+// 割り込み関数の中ではYieldFromISR()を呼んでください.
+*/
+#if (CONFIG_USE_ISR_YIELD == 1)
+    #define ISR_WAKING_TASK(vector) ISR_WITH_YIELD(vector)
+#else
+    #define ISR_WAKING_TASK(vector) ISR_ON_ISR_STACK(vector)
+#endif
+
 //アライメントされたメモリを確保する
 #ifndef PortMallocAligned
     #define PortMallocAligned(x, stackBuffer) (((stackBuffer) == NULL) ? (PortMalloc((x))) : (stackBuffer))
@@ -386,6 +649,11 @@ typedef PortBaseType(*TaskHookCode)(void *);
     #define PortFreeAligned(blockToFree) PortFree(blockToFree)
 #endif
 
+// 削除されたタスクのTCBを開放する前に, ポートが確保した資源を開放する
+#ifndef PortCleanUpTCB
+    #define PortCleanUpTCB(tcb)
+#endif
+
 
 
 // ---------------------------------------------------------------
@@ -543,6 +811,13 @@ typedef PortBaseType(*TaskHookCode)(void *);
 #include "Portable.h"
 
 #include "Semaphore.h"
+#include "MessageBuffer.h"
+#include "BroadcastChannel.h"
+#include "CriticalProfiler.h"
+
+#if !defined(ARDUINOS_PORT_POSIX)
+    #include "PortContext.h"
+#endif
 
 // ---------------------------------------------------------------
 // アプリケーションとOS間の中間関数
@@ -777,7 +1052,7 @@ TaskLoop(taskA)
 // @param ms:
 //  待機時間(ms)
 //  
-#define TaskDelayMillis(ms) TaskDelay((ms) / PORT_TICK_RATE_MS)
+#define TaskDelayMillis(ms) TaskDelay(PORT_MILLIS_TO_TICKS(ms))
 
 /*
 //
@@ -788,7 +1063,7 @@ TaskLoop(taskA)
 //
 // @param frequency:
 //  サイクル周期(ms).
-//  タスクが次に待機状態を抜ける時間は, previousWakeTime(tick) + frequency(ms) / PORT_TICK_RATE_MS(ms / tick) です.
+//  タスクが次に待機状態を抜ける時間は, previousWakeTime(tick) + PORT_MILLIS_TO_TICKS(frequency(ms)) です.
 //
 // Example usage :
 
@@ -812,7 +1087,7 @@ TaskLoop(taskA)
 }
 */
 #define TaskDelayUntilMillis(previousWakeTime, frequency)              \
-    TaskDelayUntil((previousWakeTime), (frequency) / PORT_TICK_RATE_MS)
+    TaskDelayUntil((previousWakeTime), PORT_MILLIS_TO_TICKS(frequency))
 // ------------------------------------------------------
 
 // --- Semaphore, Mutex 関係 -------------------------------------------
@@ -922,7 +1197,7 @@ TaskLoop(taskA)
 
 */
 #define Acquire(semaphore, blockTime)                     \
-    (SemahoreTake((semaphore), ((PortTickType)(blockTime)) / PORT_TICK_RATE_MS) == PD_TRUE)
+    (SemaphoreTake((semaphore), PORT_MILLIS_TO_TICKS(blockTime)) == PD_TRUE)
 
 
 /*
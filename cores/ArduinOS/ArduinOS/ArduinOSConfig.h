@@ -68,7 +68,9 @@ licensing and training services.
 
 //#define __AVR_ATmega328P__
 
-#if defined(__AVR_ATmega328P__)
+#if defined(ARDUINOS_PORT_POSIX)
+    #include "Posix/ArduinOSConfigPosix.h"
+#elif defined(__AVR_ATmega328P__)
     #include "ArduinOSConfigAtmega328P.h"
 
 #elif defined(__AVR_ATmega2560__)
@@ -94,6 +96,9 @@ licensing and training services.
 // クロック周波数ごとのTimer割り込み周波数:
 //  クロック周波数: 16Mhz
 //   Timer割り込み周波数: 16Mhz / (256 * 64) = 976.5625 Hz
+//
+// CONFIG_TICK_SOURCE に PORT_TICK_SOURCE_TIMER1 または PORT_TICK_SOURCE_TIMER2 を
+// 設定した場合は, tickはここで設定した周波数で正確に発生します.
 #ifndef CONFIG_TICK_RATE_HZ
 
     #if F_CPU >= 20000000L
@@ -0,0 +1,601 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "ArduinOS.h"
+#include "Task.h"
+#include "BroadcastChannel.h"
+
+
+#define BROADCAST_CHANNEL_UNLOCKED ((signed PortBaseType)-1)
+#define BROADCAST_CHANNEL_LOCKED_UNMODIFIED ((signed PortBaseType)0)
+
+//
+// 送信数と購読者の読み取り数は unsigned PortBaseType で数え, オーバーフローで一周させます.
+// 購読者の遅れ(writeCount - readCount)は常にチャネルの長さ以下に保たれるため,
+// チャネルの長さが型の最大値以下であれば差は正しく求まります.
+//
+
+struct BroadcastChannelDefinition;
+
+typedef struct BroadcastSubscriberDefinition
+{
+    // The channel this subscriber reads from.
+    struct BroadcastChannelDefinition *channel;
+
+    // The next subscriber of the same channel.
+    struct BroadcastSubscriberDefinition *next;
+
+    // The number of items this subscriber has consumed, including the lost ones.
+    volatile unsigned PortBaseType readCount;
+
+    // Index of the next item this subscriber will read.
+    volatile unsigned PortBaseType readFrom;
+
+    // The number of items overwritten before this subscriber read them.
+    volatile unsigned short lostCount;
+}BroadcastSubscriber;
+
+typedef struct BroadcastChannelDefinition
+{
+    // Points to the beginning of the storage area.
+    signed char *storage;
+
+    // The number of items the channel can hold, and the size of each item.
+    unsigned PortBaseType length;
+    unsigned PortBaseType itemSize;
+
+    // BROADCAST_OVERWRITE_OLDEST or BROADCAST_BLOCK_PUBLISHER.
+    PortBaseType overrunPolicy;
+
+    // Index of the next item to be written.
+    volatile unsigned PortBaseType writeTo;
+
+    // The number of items published so far.
+    volatile unsigned PortBaseType writeCount;
+
+    // Singly linked list of the subscribers.
+    BroadcastSubscriber *subscribers;
+
+    // List of tasks that are blocked waiting for the slowest subscriber. Stored in priority order.
+    List tasksWaitingToSend;
+
+    // List of subscriber tasks that are blocked waiting for a new item. Stored in priority order.
+    List tasksWaitingToReceive;
+
+    // Stores the number of items published from an ISR while the channel was locked.
+    // Set to BROADCAST_CHANNEL_UNLOCKED when the channel is not locked.
+    // Items are only received from tasks, so no rxLock is required.
+    volatile signed PortBaseType txLock;
+}BroadcastChannel;
+
+//
+// Unlocks a channel locked by LockBroadcastChannel. Wakes the subscribers
+// that an ISR would have woken had the channel not been locked.
+//
+static void UnlockBroadcastChannel(BroadcastChannel *channel);
+
+//
+// 一番遅い購読者の遅れを返します. クリティカルセクション内で呼んでください.
+//
+static unsigned PortBaseType GetMaxLag(BroadcastChannel *channel);
+
+//
+// アイテムをリングに一度だけコピーし, 上書き方針の場合は遅れている購読者を進めます.
+// The caller must have checked that the item may be written.
+//
+static void PublishItem(BroadcastChannel *channel, const void * const itemToSend);
+
+//
+// 受信待ちのタスクをすべて起床させます.
+// Queueでは一つのアイテムで起床させるタスクは一つですが, ここではすべての購読者が受信できます.
+//
+// @return:
+//  PD_TRUE if a woken task has a priority higher than the current task.
+//
+static signed PortBaseType WakeAllSubscribers(BroadcastChannel *channel);
+
+//
+// Uses a critical section to determine if the channel can accept an item.
+//
+static signed PortBaseType IsBroadcastChannelFull(BroadcastChannel *channel);
+
+//
+// Uses a critical section to determine if the subscriber has an unread item.
+//
+static signed PortBaseType IsSubscriberEmpty(BroadcastSubscriber *subscriber);
+
+//
+// Macro to mark a channel as locked. Locking prevents an ISR from
+// accessing the event lists.
+//
+#define LockBroadcastChannel(channel)                                           \
+    TaskEnterCritical();                                                        \
+    {                                                                           \
+        if((channel)->txLock == BROADCAST_CHANNEL_UNLOCKED)                     \
+        {                                                                       \
+            (channel)->txLock = BROADCAST_CHANNEL_LOCKED_UNMODIFIED;            \
+        }                                                                       \
+    }                                                                           \
+    TaskExitCritical();
+
+//
+// 購読者の遅れ(未受信アイテム数)
+//
+#define LagOf(subscriber) ((unsigned PortBaseType)((subscriber)->channel->writeCount - (subscriber)->readCount))
+
+//
+// リング上の次の位置
+//
+#define NextIndex(channel, index) ((((index) + 1U) >= (channel)->length) ? 0U : ((index) + 1U))
+
+BroadcastChannelHandle BroadcastChannelCreate(unsigned PortBaseType channelLength, unsigned PortBaseType itemSize, PortBaseType overrunPolicy)
+{
+    BroadcastChannel *newChannel;
+    BroadcastChannelHandle ret = NULL;
+    size_t storageSize;
+
+    if ((channelLength > (unsigned PortBaseType)0) && (itemSize > (unsigned PortBaseType)0))
+    {
+        newChannel = (BroadcastChannel *)PortMalloc(sizeof(BroadcastChannel));
+        if (newChannel != NULL)
+        {
+            storageSize = (size_t)channelLength * (size_t)itemSize;
+            newChannel->storage = (signed char *)PortMalloc(storageSize);
+            if (newChannel->storage != NULL)
+            {
+                newChannel->length = channelLength;
+                newChannel->itemSize = itemSize;
+                newChannel->overrunPolicy = overrunPolicy;
+                newChannel->writeTo = 0U;
+                newChannel->writeCount = 0U;
+                newChannel->subscribers = NULL;
+                newChannel->txLock = BROADCAST_CHANNEL_UNLOCKED;
+
+                ListInitialise(&(newChannel->tasksWaitingToSend));
+                ListInitialise(&(newChannel->tasksWaitingToReceive));
+
+                ret = newChannel;
+            }
+            else
+            {
+                PortFree(newChannel);
+            }
+        }
+    }
+
+    return ret;
+}
+
+BroadcastSubscriberHandle BroadcastChannelSubscribe(BroadcastChannelHandle channelToSubscribe)
+{
+    BroadcastChannel *channel;
+    BroadcastSubscriber *newSubscriber;
+
+    channel = (BroadcastChannel *)channelToSubscribe;
+
+    newSubscriber = (BroadcastSubscriber *)PortMalloc(sizeof(BroadcastSubscriber));
+    if (newSubscriber != NULL)
+    {
+        newSubscriber->channel = channel;
+        newSubscriber->lostCount = 0U;
+
+        TaskEnterCritical();
+        {
+            // 購読した時点以降のアイテムだけを受信する.
+            newSubscriber->readCount = channel->writeCount;
+            newSubscriber->readFrom = channel->writeTo;
+
+            newSubscriber->next = channel->subscribers;
+            channel->subscribers = newSubscriber;
+        }
+        TaskExitCritical();
+    }
+
+    return newSubscriber;
+}
+
+void BroadcastChannelUnsubscribe(BroadcastSubscriberHandle subscriberToRemove)
+{
+    BroadcastSubscriber *subscriber;
+    BroadcastSubscriber **link;
+    BroadcastChannel *channel;
+
+    subscriber = (BroadcastSubscriber *)subscriberToRemove;
+    channel = subscriber->channel;
+
+    TaskEnterCritical();
+    {
+        for (link = &(channel->subscribers); *link != NULL; link = &((*link)->next))
+        {
+            if (*link == subscriber)
+            {
+                *link = subscriber->next;
+                break;
+            }
+        }
+
+        // The removed subscriber may have been the one the publisher was waiting for.
+        if (ListListIsEmpty(&(channel->tasksWaitingToSend)) == PD_FALSE)
+        {
+            if (TaskRemoveFromEventList(&(channel->tasksWaitingToSend)) == PD_TRUE)
+            {
+                PortYieldWithinAPI();
+            }
+        }
+    }
+    TaskExitCritical();
+
+    PortFree(subscriber);
+}
+
+signed PortBaseType BroadcastChannelSend(BroadcastChannelHandle channelTo, const void * const itemToSend, PortTickType ticksToWait)
+{
+    signed PortBaseType entryTimeSet = PD_FALSE;
+    TimeOutType timeOut;
+    BroadcastChannel *channel;
+
+    channel = (BroadcastChannel *)channelTo;
+
+    // This function relaxes the coding standard somewhat to allow return
+    // statements within the function itself, as QueueGenericSend() does.
+    for (;;)
+    {
+        TaskEnterCritical();
+        {
+            // Has the slowest subscriber left room for the item?
+            // A channel that overwrites is never full.
+            if ((channel->overrunPolicy == BROADCAST_OVERWRITE_OLDEST) || (GetMaxLag(channel) < channel->length))
+            {
+                PublishItem(channel, itemToSend);
+
+                if (WakeAllSubscribers(channel) == PD_TRUE)
+                {
+                    PortYieldWithinAPI();
+                }
+
+                TaskExitCritical();
+                return PD_PASS;
+            }
+            else
+            {
+                if (ticksToWait == (PortTickType)0)
+                {
+                    // The channel is full and no block time is specified
+                    // (or the block time has expired).
+                    TaskExitCritical();
+                    return ERR_QUEUE_FULL;
+                }
+                else if (entryTimeSet == PD_FALSE)
+                {
+                    TaskSetTimeOutState(&timeOut);
+                    entryTimeSet = PD_TRUE;
+                }
+            }
+        }
+        TaskExitCritical();
+
+        TaskSuspendAll();
+        LockBroadcastChannel(channel);
+
+        if (TaskCheckForTimeOut(&timeOut, &ticksToWait) == PD_FALSE)
+        {
+            if (IsBroadcastChannelFull(channel) != PD_FALSE)
+            {
+                TaskPlaceOnEventList(&(channel->tasksWaitingToSend), ticksToWait);
+                UnlockBroadcastChannel(channel);
+
+                if (TaskResumeAll() == PD_FALSE)
+                {
+                    PortYieldWithinAPI();
+                }
+            }
+            else
+            {
+                // Try again.
+                UnlockBroadcastChannel(channel);
+                (void)TaskResumeAll();
+            }
+        }
+        else
+        {
+            // The timeout has expired.
+            UnlockBroadcastChannel(channel);
+            (void)TaskResumeAll();
+            return ERR_QUEUE_FULL;
+        }
+    }
+}
+
+signed PortBaseType BroadcastChannelSendFromISR(BroadcastChannelHandle channelTo, const void * const itemToSend, signed PortBaseType *higherPriorityTaskWoken)
+{
+    signed PortBaseType ret;
+    BroadcastChannel *channel;
+
+    channel = (BroadcastChannel *)channelTo;
+
+    if ((channel->overrunPolicy == BROADCAST_OVERWRITE_OLDEST) || (GetMaxLag(channel) < channel->length))
+    {
+        PublishItem(channel, itemToSend);
+
+        // If the channel is locked we do not alter the event list. This will
+        // be done when the channel is unlocked later.
+        if (channel->txLock == BROADCAST_CHANNEL_UNLOCKED)
+        {
+            if (WakeAllSubscribers(channel) != PD_FALSE)
+            {
+                if (higherPriorityTaskWoken != NULL)
+                {
+                    *higherPriorityTaskWoken = PD_TRUE;
+                }
+            }
+        }
+        else
+        {
+            ++(channel->txLock);
+        }
+
+        ret = PD_PASS;
+    }
+    else
+    {
+        ret = ERR_QUEUE_FULL;
+    }
+
+    return ret;
+}
+
+signed PortBaseType BroadcastChannelReceive(BroadcastSubscriberHandle subscriberFrom, void * const buffer, PortTickType ticksToWait)
+{
+    signed PortBaseType entryTimeSet = PD_FALSE;
+    TimeOutType timeOut;
+    BroadcastSubscriber *subscriber;
+    BroadcastChannel *channel;
+
+    subscriber = (BroadcastSubscriber *)subscriberFrom;
+    channel = subscriber->channel;
+
+    for (;;)
+    {
+        TaskEnterCritical();
+        {
+            // Is there an item this subscriber has not read yet?
+            if (LagOf(subscriber) > (unsigned PortBaseType)0)
+            {
+                memcpy(buffer, (const void *)(channel->storage + ((size_t)subscriber->readFrom * channel->itemSize)), (size_t)channel->itemSize);
+                subscriber->readFrom = NextIndex(channel, subscriber->readFrom);
+                ++(subscriber->readCount);
+
+                // This subscriber may have been the slowest one.
+                if (ListListIsEmpty(&(channel->tasksWaitingToSend)) == PD_FALSE)
+                {
+                    if (TaskRemoveFromEventList(&(channel->tasksWaitingToSend)) == PD_TRUE)
+                    {
+                        PortYieldWithinAPI();
+                    }
+                }
+
+                TaskExitCritical();
+                return PD_PASS;
+            }
+            else
+            {
+                if (ticksToWait == (PortTickType)0)
+                {
+                    TaskExitCritical();
+                    return ERR_QUEUE_EMPTY;
+                }
+                else if (entryTimeSet == PD_FALSE)
+                {
+                    TaskSetTimeOutState(&timeOut);
+                    entryTimeSet = PD_TRUE;
+                }
+            }
+        }
+        TaskExitCritical();
+
+        TaskSuspendAll();
+        LockBroadcastChannel(channel);
+
+        if (TaskCheckForTimeOut(&timeOut, &ticksToWait) == PD_FALSE)
+        {
+            if (IsSubscriberEmpty(subscriber) != PD_FALSE)
+            {
+                TaskPlaceOnEventList(&(channel->tasksWaitingToReceive), ticksToWait);
+                UnlockBroadcastChannel(channel);
+
+                if (TaskResumeAll() == PD_FALSE)
+                {
+                    PortYieldWithinAPI();
+                }
+            }
+            else
+            {
+                // Try again.
+                UnlockBroadcastChannel(channel);
+                (void)TaskResumeAll();
+            }
+        }
+        else
+        {
+            UnlockBroadcastChannel(channel);
+            (void)TaskResumeAll();
+            return ERR_QUEUE_EMPTY;
+        }
+    }
+}
+
+unsigned PortBaseType BroadcastChannelMessagesWaiting(BroadcastSubscriberHandle subscriber)
+{
+    unsigned PortBaseType ret;
+
+    TaskEnterCritical();
+    {
+        ret = LagOf((BroadcastSubscriber *)subscriber);
+    }
+    TaskExitCritical();
+
+    return ret;
+}
+
+unsigned short BroadcastChannelGetLostCount(BroadcastSubscriberHandle subscriber)
+{
+    unsigned short ret;
+
+    TaskEnterCritical();
+    {
+        ret = ((BroadcastSubscriber *)subscriber)->lostCount;
+    }
+    TaskExitCritical();
+
+    return ret;
+}
+
+unsigned PortBaseType BroadcastChannelGetMaxLag(BroadcastChannelHandle channel)
+{
+    unsigned PortBaseType ret;
+
+    TaskEnterCritical();
+    {
+        ret = GetMaxLag((BroadcastChannel *)channel);
+    }
+    TaskExitCritical();
+
+    return ret;
+}
+
+void BroadcastChannelDelete(BroadcastChannelHandle channelToDelete)
+{
+    BroadcastChannel *channel;
+
+    channel = (BroadcastChannel *)channelToDelete;
+
+    PortFree(channel->storage);
+    PortFree(channel);
+}
+
+static unsigned PortBaseType GetMaxLag(BroadcastChannel *channel)
+{
+    BroadcastSubscriber *subscriber;
+    unsigned PortBaseType lag;
+    unsigned PortBaseType maxLag = 0U;
+
+    for (subscriber = channel->subscribers; subscriber != NULL; subscriber = subscriber->next)
+    {
+        lag = LagOf(subscriber);
+        if (lag > maxLag)
+        {
+            maxLag = lag;
+        }
+    }
+
+    return maxLag;
+}
+
+static void PublishItem(BroadcastChannel *channel, const void * const itemToSend)
+{
+    BroadcastSubscriber *subscriber;
+
+    // 上書きされる位置をまだ読んでいない購読者は, 最も古いアイテムを失う.
+    // BROADCAST_BLOCK_PUBLISHERでは, ここに来るときに遅れがlengthの購読者はいない.
+    for (subscriber = channel->subscribers; subscriber != NULL; subscriber = subscriber->next)
+    {
+        if (LagOf(subscriber) >= channel->length)
+        {
+            subscriber->readFrom = NextIndex(channel, subscriber->readFrom);
+            ++(subscriber->readCount);
+            ++(subscriber->lostCount);
+        }
+    }
+
+    // 購読者の数に関わらずコピーは一回.
+    memcpy((void *)(channel->storage + ((size_t)channel->writeTo * channel->itemSize)), itemToSend, (size_t)channel->itemSize);
+    channel->writeTo = NextIndex(channel, channel->writeTo);
+    ++(channel->writeCount);
+}
+
+static signed PortBaseType WakeAllSubscribers(BroadcastChannel *channel)
+{
+    signed PortBaseType ret = PD_FALSE;
+
+    while (ListListIsEmpty(&(channel->tasksWaitingToReceive)) == PD_FALSE)
+    {
+        if (TaskRemoveFromEventList(&(channel->tasksWaitingToReceive)) != PD_FALSE)
+        {
+            ret = PD_TRUE;
+        }
+    }
+
+    return ret;
+}
+
+static void UnlockBroadcastChannel(BroadcastChannel *channel)
+{
+    // THIS FUNCTION MUST BE CALLED WITH THE SCHEDULER SUSPENDED.
+
+    TaskEnterCritical();
+    {
+        // Items published while the channel was locked are available to every
+        // subscriber, so one wake-up pass is enough however many there were.
+        if (channel->txLock > BROADCAST_CHANNEL_LOCKED_UNMODIFIED)
+        {
+            if (WakeAllSubscribers(channel) != PD_FALSE)
+            {
+                TaskMissedYield();
+            }
+        }
+        channel->txLock = BROADCAST_CHANNEL_UNLOCKED;
+    }
+    TaskExitCritical();
+}
+
+static signed PortBaseType IsBroadcastChannelFull(BroadcastChannel *channel)
+{
+    signed PortBaseType ret;
+
+    TaskEnterCritical();
+    {
+        if ((channel->overrunPolicy == BROADCAST_BLOCK_PUBLISHER) && (GetMaxLag(channel) >= channel->length))
+        {
+            ret = PD_TRUE;
+        }
+        else
+        {
+            ret = PD_FALSE;
+        }
+    }
+    TaskExitCritical();
+
+    return ret;
+}
+
+static signed PortBaseType IsSubscriberEmpty(BroadcastSubscriber *subscriber)
+{
+    signed PortBaseType ret;
+
+    TaskEnterCritical();
+    {
+        if (LagOf(subscriber) == (unsigned PortBaseType)0)
+        {
+            ret = PD_TRUE;
+        }
+        else
+        {
+            ret = PD_FALSE;
+        }
+    }
+    TaskExitCritical();
+
+    return ret;
+}
@@ -0,0 +1,179 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+
+/*
+// ブロードキャストチャネル
+//
+// 一つのメッセージをすべての購読者(サブスクライバ)に届けます.
+// Queueでは一つのアイテムは一つのタスクにしか届かないため, 4つのタスクに同じデータを
+// 配るには4つのQueueと4回のコピーが必要でした.
+// ブロードキャストチャネルでは共有の一つのリングにデータを一度だけコピーし,
+// 各購読者は自分の読み取り位置(カーソル)を持ちます.
+//
+// リングが一番遅い購読者のデータで埋まっているときの動作(オーバーラン方針)は
+// チャネル作成時に選択します.
+//  BROADCAST_OVERWRITE_OLDEST:
+//   送信は待機しません. 遅れている購読者の最も古いデータが上書きされ,
+//   その購読者の失われたメッセージ数(lostCount)に加算されます.
+//  BROADCAST_BLOCK_PUBLISHER:
+//   一番遅い購読者が読み取るまで, 送信側が待機します.
+*/
+
+#ifndef ARDUINOS_BROADCAST_CHANNEL_H
+#define ARDUINOS_BROADCAST_CHANNEL_H
+
+#ifndef ARDUINOS_H
+    #error "include ArduinOS.h" must appear in source files before "include BroadcastChannel.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    //
+    // Type by which broadcast channels are referenced.
+    //
+    typedef void * BroadcastChannelHandle;
+
+    //
+    // Type by which the subscriptions to a broadcast channel are referenced.
+    //
+    typedef void * BroadcastSubscriberHandle;
+
+    // Overrun policies.
+#define BROADCAST_OVERWRITE_OLDEST (0)
+#define BROADCAST_BLOCK_PUBLISHER (1)
+
+    /*
+    // ブロードキャストチャネルを作成します.
+    //
+    // @param channelLength:
+    //  The number of items the shared ring can hold.
+    //
+    // @param itemSize:
+    //  The number of bytes each item requires.
+    //
+    // @param overrunPolicy:
+    //  BROADCAST_OVERWRITE_OLDEST or BROADCAST_BLOCK_PUBLISHER.
+    //
+    // @return:
+    //  A handle to the newly created channel, or NULL if it could not be created.
+    //
+    // Example usage:
+
+    BroadcastChannelHandle sampleChannel;
+
+    void setup()
+    {
+        sampleChannel = BroadcastChannelCreate(8, sizeof(int), BROADCAST_OVERWRITE_OLDEST);
+    }
+
+    TaskLoop(samplerTask)
+    {
+        int sample = analogRead(A0);
+
+        // 購読者がいくつあってもコピーは一回.
+        BroadcastChannelSend(sampleChannel, &sample, (PortTickType)0);
+        TaskDelayMillis(10);
+    }
+
+    TaskLoop(filterTask)
+    {
+        static BroadcastSubscriberHandle subscriber = NULL;
+        int sample;
+
+        if (subscriber == NULL)
+        {
+            subscriber = BroadcastChannelSubscribe(sampleChannel);
+        }
+
+        if (BroadcastChannelReceive(subscriber, &sample, PORT_MAX_DELAY) == PD_PASS)
+        {
+            // ...
+        }
+    }
+    */
+    BroadcastChannelHandle BroadcastChannelCreate(unsigned PortBaseType channelLength, unsigned PortBaseType itemSize, PortBaseType overrunPolicy);
+
+    /*
+    // チャネルを購読します. 購読者は購読した時点以降に送信されたメッセージを受信します.
+    //
+    // @return:
+    //  A handle to the new subscriber, or NULL if it could not be allocated.
+    */
+    BroadcastSubscriberHandle BroadcastChannelSubscribe(BroadcastChannelHandle channel);
+
+    /*
+    // 購読を解除します. subscriberのメモリは解放されます.
+    // 解除する購読者で待機しているタスクがあってはいけません.
+    */
+    void BroadcastChannelUnsubscribe(BroadcastSubscriberHandle subscriber);
+
+    /*
+    // すべての購読者にメッセージを送信します.
+    // この関数は割り込み関数の中で呼ばないようにしてください.
+    //
+    // @param ticksToWait:
+    //  BROADCAST_BLOCK_PUBLISHERのチャネルで, 一番遅い購読者が読み取るまで待機する最大時間.
+    //  BROADCAST_OVERWRITE_OLDESTのチャネルでは使用されません.
+    //
+    // @return:
+    //  PD_PASS if the item was published, otherwise ERR_QUEUE_FULL.
+    */
+    signed PortBaseType BroadcastChannelSend(BroadcastChannelHandle channel, const void * const itemToSend, PortTickType ticksToWait);
+
+    /*
+    // BroadcastChannelSend()の割り込み関数用です. 待機は行いません.
+    //
+    // @param higherPriorityTaskWoken:
+    //  Set to PD_TRUE if publishing woke a task with a priority higher than
+    //  the currently running task.
+    */
+    signed PortBaseType BroadcastChannelSendFromISR(BroadcastChannelHandle channel, const void * const itemToSend, signed PortBaseType *higherPriorityTaskWoken);
+
+    /*
+    // 購読者のカーソル位置にある次のメッセージを受信します.
+    // 新しいメッセージがない場合, ticksToWaitの間待機します.
+    //
+    // @return:
+    //  PD_PASS if an item was received, otherwise ERR_QUEUE_EMPTY.
+    */
+    signed PortBaseType BroadcastChannelReceive(BroadcastSubscriberHandle subscriber, void * const buffer, PortTickType ticksToWait);
+
+    /*
+    // 購読者がまだ受信していないメッセージの数を返します.
+    */
+    unsigned PortBaseType BroadcastChannelMessagesWaiting(BroadcastSubscriberHandle subscriber);
+
+    /*
+    // 上書きにより購読者が受信できなかったメッセージの総数を返します.
+    // BROADCAST_OVERWRITE_OLDESTのチャネルでのみ増加します.
+    */
+    unsigned short BroadcastChannelGetLostCount(BroadcastSubscriberHandle subscriber);
+
+    /*
+    // 一番遅い購読者の遅れ(未受信メッセージ数)を返します.
+    // チャネルの長さに近い値が続く場合は, チャネルを長くするか購読者の優先度を見直してください.
+    */
+    unsigned PortBaseType BroadcastChannelGetMaxLag(BroadcastChannelHandle channel);
+
+    /*
+    // チャネルを削除します. すべての購読を解除してから呼んでください.
+    */
+    void BroadcastChannelDelete(BroadcastChannelHandle channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,187 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+#include <string.h>
+
+#include "ArduinOS.h"
+#include "CriticalProfiler.h"
+
+#if (CONFIG_USE_CRITICAL_PROFILER == 1) && !defined(ARDUINOS_PORT_POSIX)
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+static CriticalProfilerSite sites[CONFIG_CRITICAL_PROFILER_SITES];
+static unsigned PortBaseType siteCount = 0;
+static unsigned short droppedCount = 0;
+
+// 測定中の割り込み禁止区間.
+// 割り込みが禁止されている間だけ書き換えられるため, 一つで足りる.
+static const char *windowFile;
+static unsigned short windowLine;
+static unsigned char windowStart;
+static unsigned char windowActive = 0;
+
+static void RecordWindow(unsigned short duration);
+
+//
+// PortEnterCritical()から呼ばれる. 割り込みを禁止し, 元のSREGを返す.
+// 割り込みが許可されていたときだけ, 区間の始まりとして記録する.
+//
+unsigned char CriticalProfilerEnter(const char *file, unsigned short line)
+{
+    unsigned char sreg = SREG;
+
+    cli();
+    if (sreg & _BV(SREG_I))
+    {
+        #if (CONFIG_TICK_SOURCE != PORT_TICK_SOURCE_TIMER0)
+        {
+            // Timer0のオーバーフロー割り込みは使用されていないため,
+            // フラグを区間内での桁あふれの検出に使う.
+            TIFR0 = _BV(TOV0);
+        }
+        #endif
+
+        windowFile = file;
+        windowLine = line;
+        windowStart = TCNT0;
+        windowActive = 1;
+    }
+
+    return sreg;
+}
+
+//
+// PortExitCritical()から呼ばれる. 戻すSREGで割り込みが許可されるとき, 区間を記録する.
+//
+void CriticalProfilerExit(unsigned char sreg)
+{
+    unsigned char now;
+    unsigned short duration;
+
+    if ((sreg & _BV(SREG_I)) && windowActive)
+    {
+        now = TCNT0;
+        duration = (unsigned char)(now - windowStart);
+
+        // 桁あふれが1回なら差で求まる. 保留中のオーバーフローがあり, 差で
+        // 求まらないときは1周分を足す.
+        if ((TIFR0 & _BV(TOV0)) && (now >= windowStart))
+        {
+            duration += 256;
+        }
+
+        windowActive = 0;
+        RecordWindow(duration);
+    }
+
+    SREG = sreg;
+}
+
+static void RecordWindow(unsigned short duration)
+{
+    CriticalProfilerSite *site;
+    unsigned PortBaseType index;
+    unsigned char bucket;
+
+    for (index = 0; index < siteCount; index++)
+    {
+        if ((sites[index].file == windowFile) && (sites[index].line == windowLine))
+        {
+            break;
+        }
+    }
+
+    if (index == siteCount)
+    {
+        if (siteCount >= CONFIG_CRITICAL_PROFILER_SITES)
+        {
+            if (droppedCount != 0xffff)
+            {
+                droppedCount++;
+            }
+            return;
+        }
+
+        memset(&sites[index], 0, sizeof(CriticalProfilerSite));
+        sites[index].file = windowFile;
+        sites[index].line = windowLine;
+        siteCount++;
+    }
+
+    site = &sites[index];
+
+    if (duration > site->maxDuration)
+    {
+        site->maxDuration = duration;
+    }
+
+    if (site->count != 0xffff)
+    {
+        site->count++;
+    }
+
+    for (bucket = 0; bucket < (CRITICAL_PROFILER_BUCKETS - 1); bucket++)
+    {
+        if (duration < (2U << bucket))
+        {
+            break;
+        }
+    }
+
+    if (site->histogram[bucket] != 0xffff)
+    {
+        site->histogram[bucket]++;
+    }
+}
+
+unsigned PortBaseType CriticalProfilerGetSiteCount(void)
+{
+    return siteCount;
+}
+
+signed PortBaseType CriticalProfilerGetSite(unsigned PortBaseType index, CriticalProfilerSite *site)
+{
+    unsigned char sreg;
+    signed PortBaseType ret = PD_FAIL;
+
+    // PortEnterCritical()を使うと自分自身が記録されるため, 直接割り込みを禁止する.
+    sreg = SREG;
+    cli();
+    if (index < siteCount)
+    {
+        memcpy(site, &sites[index], sizeof(CriticalProfilerSite));
+        ret = PD_PASS;
+    }
+    SREG = sreg;
+
+    return ret;
+}
+
+unsigned short CriticalProfilerGetDroppedCount(void)
+{
+    return droppedCount;
+}
+
+void CriticalProfilerReset(void)
+{
+    unsigned char sreg;
+
+    sreg = SREG;
+    cli();
+    siteCount = 0;
+    droppedCount = 0;
+    SREG = sreg;
+}
+
+#endif
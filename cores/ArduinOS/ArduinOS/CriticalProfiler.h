@@ -0,0 +1,126 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+
+/*
+// クリティカルセクションプロファイラ
+//
+// CONFIG_USE_CRITICAL_PROFILER が1のとき, PortEnterCritical()で割り込みが禁止されてから
+// 再び許可されるまでの時間を, 割り込みを禁止した呼び出し元(ファイルと行)ごとに記録します.
+// シリアルの取りこぼしなど, 割り込みの遅れの原因となる長いクリティカルセクションを探すために使用します.
+//
+// 時間はTCNT0のカウント(分周64. 16Mhzでは4us)で測定されます.
+// tick割り込みがTimer0のとき, 1tick以上続いたクリティカルセクションは短く記録されます.
+// クリティカルセクション内でタスクが切り替わった場合は, 割り込みが許可されるまでを
+// 割り込みを禁止した呼び出し元の時間として記録します.
+//
+// CONFIG_USE_CRITICAL_PROFILER はPortMacro.hで使用されるため, ArduinOSConfig.hで定義してください.
+*/
+
+#ifndef ARDUINOS_CRITICAL_PROFILER_H
+#define ARDUINOS_CRITICAL_PROFILER_H
+
+#ifndef ARDUINOS_H
+    #error "include ArduinOS.h" must appear in source files before "include CriticalProfiler.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (CONFIG_USE_CRITICAL_PROFILER == 1)
+
+    //
+    // ヒストグラムの区間の数.
+    // 区間iには (1 << i) 以上 (2 << i) 未満のカウントの時間が入ります(区間0は2未満).
+    // 最後の区間にはそれ以上の時間がすべて入ります.
+    //
+#define CRITICAL_PROFILER_BUCKETS 8
+
+    // TCNT0のカウントをusに変換します.
+#define CRITICAL_PROFILER_COUNTS_TO_MICROS(counts) ((unsigned long)(counts) * 64UL / (F_CPU / 1000000UL))
+
+    //
+    // 呼び出し元ごとの記録.
+    //
+    typedef struct
+    {
+        // ファイル名. プログラムメモリ上の文字列です(Serial.print((const __FlashStringHelper *)file)).
+        const char *file;
+        unsigned short line;
+
+        // 割り込み禁止時間の最大値(TCNT0のカウント)
+        unsigned short maxDuration;
+
+        // 記録された回数
+        unsigned short count;
+
+        unsigned short histogram[CRITICAL_PROFILER_BUCKETS];
+    } CriticalProfilerSite;
+
+    /*
+    // 記録されている呼び出し元の数を返します.
+    */
+    unsigned PortBaseType CriticalProfilerGetSiteCount(void);
+
+    /*
+    // 呼び出し元の記録を取得します.
+    //
+    // @param index:
+    //  0 から CriticalProfilerGetSiteCount() - 1 まで.
+    //
+    // @param site:
+    //  記録のコピー先.
+    //
+    // @return:
+    //  PD_PASS if the site exists, otherwise PD_FAIL.
+    //
+    // Example usage:
+
+    TaskLoop(reportTask)
+    {
+        CriticalProfilerSite site;
+
+        for (unsigned char i = 0; i < CriticalProfilerGetSiteCount(); i++)
+        {
+            if (CriticalProfilerGetSite(i, &site) == PD_PASS)
+            {
+                Serial.print((const __FlashStringHelper *)site.file);
+                Serial.print(':');
+                Serial.print(site.line);
+                Serial.print(F(" max(us)="));
+                Serial.println(CRITICAL_PROFILER_COUNTS_TO_MICROS(site.maxDuration));
+            }
+        }
+        TaskDelayMillis(5000);
+    }
+    */
+    signed PortBaseType CriticalProfilerGetSite(unsigned PortBaseType index, CriticalProfilerSite *site);
+
+    /*
+    // 記録する場所がなく, 記録されなかった回数を返します.
+    // 0でない場合はCONFIG_CRITICAL_PROFILER_SITESを大きくしてください.
+    */
+    unsigned short CriticalProfilerGetDroppedCount(void);
+
+    /*
+    // すべての記録を消去します.
+    */
+    void CriticalProfilerReset(void);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,654 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "ArduinOS.h"
+#include "Task.h"
+#include "MessageBuffer.h"
+
+
+#define MESSAGE_BUFFER_UNLOCKED ((signed PortBaseType)-1)
+#define MESSAGE_BUFFER_LOCKED_UNMODIFIED ((signed PortBaseType)0)
+
+typedef struct
+{
+    // Points to the beginning of the storage area.
+    unsigned char *buffer;
+
+    // The size of the storage area in bytes.
+    size_t length;
+
+    // Index of the next byte to be written.
+    volatile size_t writeTo;
+
+    // Index of the next byte to be read.
+    volatile size_t readFrom;
+
+    // The number of bytes currently stored, including the length prefixes.
+    volatile size_t bytesUsed;
+
+    // List of tasks that are blocked waiting for space. Stored in priority order.
+    List tasksWaitingToSend;
+
+    // List of tasks that are blocked waiting for a message. Stored in priority order.
+    List tasksWaitingToReceive;
+
+    // Stores the number of messages received from the buffer while it was locked.
+    // Set to MESSAGE_BUFFER_UNLOCKED when the buffer is not locked.
+    volatile signed PortBaseType rxLock;
+
+    // Stores the number of messages sent to the buffer while it was locked.
+    // Set to MESSAGE_BUFFER_UNLOCKED when the buffer is not locked.
+    volatile signed PortBaseType txLock;
+}MessageBuffer;
+
+//
+// Unlocks a message buffer locked by LockMessageBuffer. Wakes the tasks
+// that an ISR would have woken had the buffer not been locked.
+//
+static void UnlockMessageBuffer(MessageBuffer *messageBuffer);
+
+//
+// Copies a length-prefixed message into the ring.
+// The caller must have checked that there is enough space.
+//
+static void WriteMessage(MessageBuffer *messageBuffer, const void *data, size_t dataLength);
+
+//
+// Copies the next message out of the ring.
+//
+// @return:
+//  The length of the message. 0 if the buffer is empty or the next message
+//  does not fit into bufferLength, in which case the message is left in place.
+//
+static size_t ReadMessage(MessageBuffer *messageBuffer, void *buffer, size_t bufferLength);
+
+//
+// リングの指定位置から指定バイト数をコピーします. リングの終端で折り返します.
+//
+// @return:
+//  コピー後のリング内の位置
+//
+static size_t CopyToRing(MessageBuffer *messageBuffer, size_t to, const void *data, size_t count);
+static size_t CopyFromRing(MessageBuffer *messageBuffer, size_t from, void *data, size_t count);
+
+//
+// Uses a critical section to determine if there is room for a message of
+// the given length.
+//
+static signed PortBaseType IsMessageBufferFull(MessageBuffer *messageBuffer, size_t dataLength);
+
+//
+// Uses a critical section to determine if there is any message.
+//
+static signed PortBaseType IsMessageBufferEmpty(MessageBuffer *messageBuffer);
+
+//
+// Macro to mark a message buffer as locked. Locking prevents an ISR from
+// accessing the event lists.
+//
+#define LockMessageBuffer(messageBuffer)                                        \
+    TaskEnterCritical();                                                        \
+    {                                                                           \
+        if((messageBuffer)->rxLock == MESSAGE_BUFFER_UNLOCKED)                  \
+        {                                                                       \
+            (messageBuffer)->rxLock = MESSAGE_BUFFER_LOCKED_UNMODIFIED;         \
+        }                                                                       \
+        if((messageBuffer)->txLock == MESSAGE_BUFFER_UNLOCKED)                  \
+        {                                                                       \
+            (messageBuffer)->txLock = MESSAGE_BUFFER_LOCKED_UNMODIFIED;         \
+        }                                                                       \
+    }                                                                           \
+    TaskExitCritical();
+
+//
+// 空き容量(byte)
+//
+#define SpaceOf(messageBuffer) ((messageBuffer)->length - (messageBuffer)->bytesUsed)
+
+MessageBufferHandle MessageBufferCreate(size_t bufferSizeBytes)
+{
+    MessageBuffer *newMessageBuffer;
+    MessageBufferHandle ret = NULL;
+
+    // A buffer that cannot hold even a one byte message is useless.
+    if (bufferSizeBytes > MESSAGE_BUFFER_LENGTH_BYTES)
+    {
+        newMessageBuffer = (MessageBuffer *)PortMalloc(sizeof(MessageBuffer));
+        if (newMessageBuffer != NULL)
+        {
+            newMessageBuffer->buffer = (unsigned char *)PortMalloc(bufferSizeBytes);
+            if (newMessageBuffer->buffer != NULL)
+            {
+                newMessageBuffer->length = bufferSizeBytes;
+                newMessageBuffer->writeTo = (size_t)0U;
+                newMessageBuffer->readFrom = (size_t)0U;
+                newMessageBuffer->bytesUsed = (size_t)0U;
+                newMessageBuffer->rxLock = MESSAGE_BUFFER_UNLOCKED;
+                newMessageBuffer->txLock = MESSAGE_BUFFER_UNLOCKED;
+
+                ListInitialise(&(newMessageBuffer->tasksWaitingToSend));
+                ListInitialise(&(newMessageBuffer->tasksWaitingToReceive));
+
+                ret = newMessageBuffer;
+            }
+            else
+            {
+                PortFree(newMessageBuffer);
+            }
+        }
+    }
+
+    return ret;
+}
+
+signed PortBaseType MessageBufferSend(MessageBufferHandle messageBufferTo, const void *data,
+    size_t dataLength, PortTickType ticksToWait)
+{
+    signed PortBaseType entryTimeSet = PD_FALSE;
+    TimeOutType timeOut;
+    MessageBuffer *messageBuffer;
+
+    messageBuffer = (MessageBuffer *)messageBufferTo;
+
+    // 長さ情報を含めてもバッファに収まらないメッセージは, 待機しても送信できない.
+    if ((dataLength == (size_t)0U) || (dataLength > (messageBuffer->length - MESSAGE_BUFFER_LENGTH_BYTES)))
+    {
+        return ERR_QUEUE_FULL;
+    }
+
+    // This function relaxes the coding standard somewhat to allow return
+    // statements within the function itself, as QueueGenericSend() does.
+    for (;;)
+    {
+        TaskEnterCritical();
+        {
+            // Is there room for the message and its length now?
+            if (SpaceOf(messageBuffer) >= (dataLength + MESSAGE_BUFFER_LENGTH_BYTES))
+            {
+                WriteMessage(messageBuffer, data, dataLength);
+
+                // If there was a task waiting for a message then unblock it now.
+                if (ListListIsEmpty(&(messageBuffer->tasksWaitingToReceive)) == PD_FALSE)
+                {
+                    if (TaskRemoveFromEventList(&(messageBuffer->tasksWaitingToReceive)) == PD_TRUE)
+                    {
+                        PortYieldWithinAPI();
+                    }
+                }
+
+                TaskExitCritical();
+                return PD_PASS;
+            }
+            else
+            {
+                if (ticksToWait == (PortTickType)0)
+                {
+                    // No room and no block time (or the block time has expired).
+                    TaskExitCritical();
+                    return ERR_QUEUE_FULL;
+                }
+                else if (entryTimeSet == PD_FALSE)
+                {
+                    TaskSetTimeOutState(&timeOut);
+                    entryTimeSet = PD_TRUE;
+                }
+            }
+        }
+        TaskExitCritical();
+
+        TaskSuspendAll();
+        LockMessageBuffer(messageBuffer);
+
+        if (TaskCheckForTimeOut(&timeOut, &ticksToWait) == PD_FALSE)
+        {
+            if (IsMessageBufferFull(messageBuffer, dataLength) != PD_FALSE)
+            {
+                TaskPlaceOnEventList(&(messageBuffer->tasksWaitingToSend), ticksToWait);
+                UnlockMessageBuffer(messageBuffer);
+
+                if (TaskResumeAll() == PD_FALSE)
+                {
+                    PortYieldWithinAPI();
+                }
+            }
+            else
+            {
+                // Try again.
+                UnlockMessageBuffer(messageBuffer);
+                (void)TaskResumeAll();
+            }
+        }
+        else
+        {
+            // The timeout has expired.
+            UnlockMessageBuffer(messageBuffer);
+            (void)TaskResumeAll();
+            return ERR_QUEUE_FULL;
+        }
+    }
+}
+
+signed PortBaseType MessageBufferSendFromISR(MessageBufferHandle messageBufferTo, const void *data,
+    size_t dataLength, signed PortBaseType *higherPriorityTaskWoken)
+{
+    signed PortBaseType ret;
+    MessageBuffer *messageBuffer;
+
+    messageBuffer = (MessageBuffer *)messageBufferTo;
+
+    if ((dataLength > (size_t)0U) && (SpaceOf(messageBuffer) >= (dataLength + MESSAGE_BUFFER_LENGTH_BYTES)))
+    {
+        WriteMessage(messageBuffer, data, dataLength);
+
+        // If the buffer is locked we do not alter the event list. This will
+        // be done when the buffer is unlocked later.
+        if (messageBuffer->txLock == MESSAGE_BUFFER_UNLOCKED)
+        {
+            if (ListListIsEmpty(&(messageBuffer->tasksWaitingToReceive)) == PD_FALSE)
+            {
+                if (TaskRemoveFromEventList(&(messageBuffer->tasksWaitingToReceive)) != PD_FALSE)
+                {
+                    if (higherPriorityTaskWoken != NULL)
+                    {
+                        *higherPriorityTaskWoken = PD_TRUE;
+                    }
+                }
+            }
+        }
+        else
+        {
+            ++(messageBuffer->txLock);
+        }
+
+        ret = PD_PASS;
+    }
+    else
+    {
+        ret = ERR_QUEUE_FULL;
+    }
+
+    return ret;
+}
+
+size_t MessageBufferReceive(MessageBufferHandle messageBufferFrom, void *buffer,
+    size_t bufferLength, PortTickType ticksToWait)
+{
+    signed PortBaseType entryTimeSet = PD_FALSE;
+    TimeOutType timeOut;
+    MessageBuffer *messageBuffer;
+    size_t receivedLength;
+
+    messageBuffer = (MessageBuffer *)messageBufferFrom;
+
+    for (;;)
+    {
+        TaskEnterCritical();
+        {
+            // Is there a message now?
+            if (messageBuffer->bytesUsed > (size_t)0U)
+            {
+                receivedLength = ReadMessage(messageBuffer, buffer, bufferLength);
+
+                if (receivedLength > (size_t)0U)
+                {
+                    if (ListListIsEmpty(&(messageBuffer->tasksWaitingToSend)) == PD_FALSE)
+                    {
+                        if (TaskRemoveFromEventList(&(messageBuffer->tasksWaitingToSend)) == PD_TRUE)
+                        {
+                            PortYieldWithinAPI();
+                        }
+                    }
+                }
+
+                TaskExitCritical();
+
+                // receivedLength is 0 when the buffer supplied was too small.
+                // Waiting would not help, so return immediately.
+                return receivedLength;
+            }
+            else
+            {
+                if (ticksToWait == (PortTickType)0)
+                {
+                    TaskExitCritical();
+                    return (size_t)0U;
+                }
+                else if (entryTimeSet == PD_FALSE)
+                {
+                    TaskSetTimeOutState(&timeOut);
+                    entryTimeSet = PD_TRUE;
+                }
+            }
+        }
+        TaskExitCritical();
+
+        TaskSuspendAll();
+        LockMessageBuffer(messageBuffer);
+
+        if (TaskCheckForTimeOut(&timeOut, &ticksToWait) == PD_FALSE)
+        {
+            if (IsMessageBufferEmpty(messageBuffer) != PD_FALSE)
+            {
+                TaskPlaceOnEventList(&(messageBuffer->tasksWaitingToReceive), ticksToWait);
+                UnlockMessageBuffer(messageBuffer);
+
+                if (TaskResumeAll() == PD_FALSE)
+                {
+                    PortYieldWithinAPI();
+                }
+            }
+            else
+            {
+                // Try again.
+                UnlockMessageBuffer(messageBuffer);
+                (void)TaskResumeAll();
+            }
+        }
+        else
+        {
+            UnlockMessageBuffer(messageBuffer);
+            (void)TaskResumeAll();
+            return (size_t)0U;
+        }
+    }
+}
+
+size_t MessageBufferReceiveFromISR(MessageBufferHandle messageBufferFrom, void *buffer,
+    size_t bufferLength, signed PortBaseType *higherPriorityTaskWoken)
+{
+    size_t receivedLength;
+    MessageBuffer *messageBuffer;
+
+    messageBuffer = (MessageBuffer *)messageBufferFrom;
+
+    receivedLength = ReadMessage(messageBuffer, buffer, bufferLength);
+
+    if (receivedLength > (size_t)0U)
+    {
+        if (messageBuffer->rxLock == MESSAGE_BUFFER_UNLOCKED)
+        {
+            if (ListListIsEmpty(&(messageBuffer->tasksWaitingToSend)) == PD_FALSE)
+            {
+                if (TaskRemoveFromEventList(&(messageBuffer->tasksWaitingToSend)) != PD_FALSE)
+                {
+                    if (higherPriorityTaskWoken != NULL)
+                    {
+                        *higherPriorityTaskWoken = PD_TRUE;
+                    }
+                }
+            }
+        }
+        else
+        {
+            ++(messageBuffer->rxLock);
+        }
+    }
+
+    return receivedLength;
+}
+
+size_t MessageBufferSpacesAvailable(MessageBufferHandle messageBuffer)
+{
+    size_t ret;
+
+    TaskEnterCritical();
+    {
+        ret = SpaceOf((MessageBuffer *)messageBuffer);
+    }
+    TaskExitCritical();
+
+    return ret;
+}
+
+size_t MessageBufferBytesUsed(MessageBufferHandle messageBuffer)
+{
+    size_t ret;
+
+    TaskEnterCritical();
+    {
+        ret = ((MessageBuffer *)messageBuffer)->bytesUsed;
+    }
+    TaskExitCritical();
+
+    return ret;
+}
+
+size_t MessageBufferNextLengthBytes(MessageBufferHandle messageBufferToQuery)
+{
+    size_t ret = (size_t)0U;
+    MessageBuffer *messageBuffer;
+
+    messageBuffer = (MessageBuffer *)messageBufferToQuery;
+
+    TaskEnterCritical();
+    {
+        if (messageBuffer->bytesUsed > (size_t)0U)
+        {
+            (void)CopyFromRing(messageBuffer, messageBuffer->readFrom, &ret, MESSAGE_BUFFER_LENGTH_BYTES);
+        }
+    }
+    TaskExitCritical();
+
+    return ret;
+}
+
+signed PortBaseType MessageBufferReset(MessageBufferHandle messageBufferToReset)
+{
+    signed PortBaseType ret = PD_FAIL;
+    MessageBuffer *messageBuffer;
+
+    messageBuffer = (MessageBuffer *)messageBufferToReset;
+
+    TaskEnterCritical();
+    {
+        // Resetting while tasks are blocked would leave them waiting on a
+        // state that no longer exists.
+        if ((ListListIsEmpty(&(messageBuffer->tasksWaitingToSend)) != PD_FALSE)
+            && (ListListIsEmpty(&(messageBuffer->tasksWaitingToReceive)) != PD_FALSE))
+        {
+            messageBuffer->writeTo = (size_t)0U;
+            messageBuffer->readFrom = (size_t)0U;
+            messageBuffer->bytesUsed = (size_t)0U;
+            ret = PD_PASS;
+        }
+    }
+    TaskExitCritical();
+
+    return ret;
+}
+
+void MessageBufferDelete(MessageBufferHandle messageBufferToDelete)
+{
+    MessageBuffer *messageBuffer;
+
+    messageBuffer = (MessageBuffer *)messageBufferToDelete;
+
+    PortFree(messageBuffer->buffer);
+    PortFree(messageBuffer);
+}
+
+static size_t CopyToRing(MessageBuffer *messageBuffer, size_t to, const void *data, size_t count)
+{
+    size_t firstLength;
+
+    // リング終端までの分を先にコピーし, 残りを先頭からコピーする.
+    firstLength = messageBuffer->length - to;
+    if (firstLength > count)
+    {
+        firstLength = count;
+    }
+
+    memcpy((void *)&(messageBuffer->buffer[to]), data, firstLength);
+    if (count > firstLength)
+    {
+        memcpy((void *)messageBuffer->buffer, (const unsigned char *)data + firstLength, count - firstLength);
+    }
+
+    to += count;
+    if (to >= messageBuffer->length)
+    {
+        to -= messageBuffer->length;
+    }
+
+    return to;
+}
+
+static size_t CopyFromRing(MessageBuffer *messageBuffer, size_t from, void *data, size_t count)
+{
+    size_t firstLength;
+
+    firstLength = messageBuffer->length - from;
+    if (firstLength > count)
+    {
+        firstLength = count;
+    }
+
+    memcpy(data, (const void *)&(messageBuffer->buffer[from]), firstLength);
+    if (count > firstLength)
+    {
+        memcpy((unsigned char *)data + firstLength, (const void *)messageBuffer->buffer, count - firstLength);
+    }
+
+    from += count;
+    if (from >= messageBuffer->length)
+    {
+        from -= messageBuffer->length;
+    }
+
+    return from;
+}
+
+static void WriteMessage(MessageBuffer *messageBuffer, const void *data, size_t dataLength)
+{
+    size_t to;
+
+    to = CopyToRing(messageBuffer, messageBuffer->writeTo, &dataLength, MESSAGE_BUFFER_LENGTH_BYTES);
+    messageBuffer->writeTo = CopyToRing(messageBuffer, to, data, dataLength);
+    messageBuffer->bytesUsed += dataLength + MESSAGE_BUFFER_LENGTH_BYTES;
+}
+
+static size_t ReadMessage(MessageBuffer *messageBuffer, void *buffer, size_t bufferLength)
+{
+    size_t dataLength;
+    size_t from;
+
+    if (messageBuffer->bytesUsed == (size_t)0U)
+    {
+        return (size_t)0U;
+    }
+
+    // Peek the length first so a message that does not fit is left intact.
+    from = CopyFromRing(messageBuffer, messageBuffer->readFrom, &dataLength, MESSAGE_BUFFER_LENGTH_BYTES);
+    if (dataLength > bufferLength)
+    {
+        return (size_t)0U;
+    }
+
+    messageBuffer->readFrom = CopyFromRing(messageBuffer, from, buffer, dataLength);
+    messageBuffer->bytesUsed -= dataLength + MESSAGE_BUFFER_LENGTH_BYTES;
+
+    return dataLength;
+}
+
+static void UnlockMessageBuffer(MessageBuffer *messageBuffer)
+{
+    // THIS FUNCTION MUST BE CALLED WITH THE SCHEDULER SUSPENDED.
+
+    TaskEnterCritical();
+    {
+        // See if messages were sent while the buffer was locked.
+        while (messageBuffer->txLock > MESSAGE_BUFFER_LOCKED_UNMODIFIED)
+        {
+            if (ListListIsEmpty(&(messageBuffer->tasksWaitingToReceive)) == PD_FALSE)
+            {
+                if (TaskRemoveFromEventList(&(messageBuffer->tasksWaitingToReceive)) != PD_FALSE)
+                {
+                    TaskMissedYield();
+                }
+            }
+            else
+            {
+                break;
+            }
+
+            --(messageBuffer->txLock);
+        }
+        messageBuffer->txLock = MESSAGE_BUFFER_UNLOCKED;
+    }
+    TaskExitCritical();
+
+    // Do the same for the Rx lock.
+    TaskEnterCritical();
+    {
+        while (messageBuffer->rxLock > MESSAGE_BUFFER_LOCKED_UNMODIFIED)
+        {
+            if (ListListIsEmpty(&(messageBuffer->tasksWaitingToSend)) == PD_FALSE)
+            {
+                if (TaskRemoveFromEventList(&(messageBuffer->tasksWaitingToSend)) != PD_FALSE)
+                {
+                    TaskMissedYield();
+                }
+            }
+            else
+            {
+                break;
+            }
+
+            --(messageBuffer->rxLock);
+        }
+        messageBuffer->rxLock = MESSAGE_BUFFER_UNLOCKED;
+    }
+    TaskExitCritical();
+}
+
+static signed PortBaseType IsMessageBufferFull(MessageBuffer *messageBuffer, size_t dataLength)
+{
+    signed PortBaseType ret;
+
+    TaskEnterCritical();
+    {
+        if (SpaceOf(messageBuffer) < (dataLength + MESSAGE_BUFFER_LENGTH_BYTES))
+        {
+            ret = PD_TRUE;
+        }
+        else
+        {
+            ret = PD_FALSE;
+        }
+    }
+    TaskExitCritical();
+
+    return ret;
+}
+
+static signed PortBaseType IsMessageBufferEmpty(MessageBuffer *messageBuffer)
+{
+    signed PortBaseType ret;
+
+    TaskEnterCritical();
+    {
+        if (messageBuffer->bytesUsed == (size_t)0U)
+        {
+            ret = PD_TRUE;
+        }
+        else
+        {
+            ret = PD_FALSE;
+        }
+    }
+    TaskExitCritical();
+
+    return ret;
+}
@@ -0,0 +1,220 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+
+/*
+// メッセージバッファ
+//
+// 可変長のメッセージを一つの連続したバイトリングに格納します.
+// 各メッセージは長さ(size_t)を先頭に付けて格納されるため,
+// 使用するRAMは実際のデータ量 + メッセージごとの長さ情報分だけになります.
+//
+// Queueは全アイテムが同じ大きさ(itemSize)でなければなりませんが,
+// メッセージバッファでは 4byte のメッセージと 60byte のメッセージを
+// 同じバッファに混在させることができます.
+//
+// 注意:
+//  待機中の送信タスク(受信タスク)は一度に一つだけ起床されます.
+//  複数のタスクから送信(受信)する場合は, 優先度順に一つずつ処理されます.
+*/
+
+#ifndef ARDUINOS_MESSAGE_BUFFER_H
+#define ARDUINOS_MESSAGE_BUFFER_H
+
+#ifndef ARDUINOS_H
+    #error "include ArduinOS.h" must appear in source files before "include MessageBuffer.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    //
+    // Type by which message buffers are referenced. For example, a call to
+    // MessageBufferCreate() returns an MessageBufferHandle variable that can
+    // then be used as a parameter to MessageBufferSend(), MessageBufferReceive(), etc.
+    //
+    typedef void * MessageBufferHandle;
+
+    //
+    // 各メッセージの先頭に付けられる長さ情報のバイト数
+    //
+#define MESSAGE_BUFFER_LENGTH_BYTES (sizeof(size_t))
+
+    /*
+    // Creates a new message buffer instance. This allocates the storage
+    // required by the new message buffer and returns a handle for it.
+    //
+    // @param bufferSizeBytes:
+    //  The total number of bytes the message buffer will be able to hold.
+    //  Each message consumes its own length plus MESSAGE_BUFFER_LENGTH_BYTES.
+    //
+    // @return:
+    //  If the message buffer is successfully created then a handle to the
+    //  newly created message buffer is returned. Otherwise NULL is returned.
+    //
+    // Example usage:
+
+    MessageBufferHandle logBuffer;
+
+    void setup()
+    {
+        // 100byteのバッファを作成. 長さ情報を含めて100byteまで格納できる.
+        logBuffer = MessageBufferCreate(100);
+        if (logBuffer == NULL)
+        {
+            // The message buffer was not created and must not be used.
+        }
+    }
+    */
+    MessageBufferHandle MessageBufferCreate(size_t bufferSizeBytes);
+
+    /*
+    // メッセージをバッファの末尾に書き込みます. メッセージは参照ではなくコピーです.
+    // この関数は割り込み関数の中で呼ばないようにしてください.
+    // 割り込み内で書き込みを行いたい場合はMessageBufferSendFromISR()を使用してください.
+    //
+    // バッファに空きがない場合, ticksToWaitの間待機します.
+    //
+    // @param messageBuffer:
+    //  The handle to the message buffer to which the message is being sent.
+    //
+    // @param data:
+    //  A pointer to the message that is to be copied into the message buffer.
+    //
+    // @param dataLength:
+    //  The length of the message in bytes.
+    //
+    // @param ticksToWait:
+    //  The maximum amount of time the task should block waiting for enough
+    //  space to become available in the message buffer. The time is defined
+    //  in tick periods so the constant PORT_TICK_RATE_MS should be used to
+    //  convert to real time if this is required.
+    //
+    // @return:
+    //  PD_PASS if the message was written, otherwise ERR_QUEUE_FULL.
+    //  ERR_QUEUE_FULL is also returned without blocking if the message can
+    //  never fit in the buffer.
+    //
+    // Example usage:
+
+    TaskLoop(taskA)
+    {
+        char line[] = "temperature=23";
+
+        // 空きができるまで最大10tick待機する.
+        if (MessageBufferSend(logBuffer, line, strlen(line), (PortTickType)10) != PD_PASS)
+        {
+            // Failed to send the message, even after 10 ticks.
+        }
+    }
+    */
+    signed PortBaseType MessageBufferSend(MessageBufferHandle messageBuffer, const void *data, size_t dataLength, PortTickType ticksToWait);
+
+    /*
+    // MessageBufferSend()の割り込み関数用です. 待機は行いません.
+    //
+    // @param higherPriorityTaskWoken:
+    //  Set to PD_TRUE if writing the message caused a task to unblock, and
+    //  the unblocked task has a priority higher than the currently running task.
+    //
+    // @return:
+    //  PD_PASS if the message was written, otherwise ERR_QUEUE_FULL.
+    */
+    signed PortBaseType MessageBufferSendFromISR(MessageBufferHandle messageBuffer, const void *data, size_t dataLength, signed PortBaseType *higherPriorityTaskWoken);
+
+    /*
+    // バッファの先頭からメッセージを一つ取り出します.
+    // この関数は割り込み関数の中で呼ばないようにしてください.
+    //
+    // @param messageBuffer:
+    //  The handle to the message buffer from which a message is being received.
+    //
+    // @param buffer:
+    //  A pointer to the buffer into which the received message is to be copied.
+    //
+    // @param bufferLength:
+    //  The length of the buffer pointed to by buffer. If the next message is
+    //  longer than this, the message is left in the message buffer and 0 is
+    //  returned.
+    //
+    // @param ticksToWait:
+    //  The maximum amount of time the task should block waiting for a message,
+    //  should the message buffer be empty.
+    //
+    // @return:
+    //  The length, in bytes, of the message read from the message buffer.
+    //  0 if no message was received.
+    //
+    // Example usage:
+
+    TaskLoop(logTask)
+    {
+        char line[61];
+        size_t length;
+
+        length = MessageBufferReceive(logBuffer, line, sizeof(line) - 1, PORT_MAX_DELAY);
+        if (length > 0)
+        {
+            line[length] = '\0';
+            Serial.println(line);
+        }
+    }
+    */
+    size_t MessageBufferReceive(MessageBufferHandle messageBuffer, void *buffer, size_t bufferLength, PortTickType ticksToWait);
+
+    /*
+    // MessageBufferReceive()の割り込み関数用です. 待機は行いません.
+    //
+    // @param higherPriorityTaskWoken:
+    //  Set to PD_TRUE if reading the message caused a task to unblock, and
+    //  the unblocked task has a priority higher than the currently running task.
+    //
+    // @return:
+    //  The length, in bytes, of the message read. 0 if no message was received.
+    */
+    size_t MessageBufferReceiveFromISR(MessageBufferHandle messageBuffer, void *buffer, size_t bufferLength, signed PortBaseType *higherPriorityTaskWoken);
+
+    /*
+    // バッファの空き容量(byte)を返します.
+    // 書き込めるメッセージの最大長は, この値からMESSAGE_BUFFER_LENGTH_BYTESを引いたものです.
+    */
+    size_t MessageBufferSpacesAvailable(MessageBufferHandle messageBuffer);
+
+    /*
+    // バッファに格納されているバイト数(長さ情報を含む)を返します.
+    */
+    size_t MessageBufferBytesUsed(MessageBufferHandle messageBuffer);
+
+    /*
+    // 次に受信されるメッセージの長さ(byte)を返します. 空の場合は0を返します.
+    */
+    size_t MessageBufferNextLengthBytes(MessageBufferHandle messageBuffer);
+
+    /*
+    // Reset a message buffer back to its original empty state.
+    // PD_FAIL is returned if tasks are blocked on the message buffer.
+    */
+    signed PortBaseType MessageBufferReset(MessageBufferHandle messageBuffer);
+
+    /*
+    // Delete a message buffer - freeing all the memory allocated for it.
+    */
+    void MessageBufferDelete(MessageBufferHandle messageBuffer);
+
+#define MessageBufferIsEmpty(messageBuffer) (MessageBufferBytesUsed(messageBuffer) == (size_t)0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
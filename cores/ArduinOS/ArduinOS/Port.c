@@ -112,181 +112,24 @@ mission critical applications that require provable dependability.
 // ******************************************************
 #define PORT_FLAGS_INT_ENABLED ((PortStackType)0x80)
 
-
 // We require the address of the currentTCB variable, but don't want to know
 // any details of its type.
 typedef void TaskControlBlock;
 extern volatile TaskControlBlock * volatile currentTCB;
 
-// 汎用レジスタの保存, スタックポインタをTCBに保存
-//
-// まずやることはフラグの保存(ステータスレジスタの保存)そのあと割り込み停止である.
-//
-// Macro to save all the general purpose registers, the save the stack pointer into the TCB.
-// 
-// The first thing we do is save the flags then disable interrupts.
-// This is to guard our stack against having a contex switch interrupt after we have already
-// pushed the resisters onto the stack - causing the 32 registers to be on the stack twice.
-//
-// r1 is set to zero as the compiler expects it to be thus, 
-// however some of the math routines make use of r1.
-//
-// The interupts will have been disabled during the call to PortSaveContext()
-// so we need not worry about reading/writing to the stack pointer.
-// 
-// *** Memo ***************************************************
-// x: Xレジスタ(R26 : R27)
-// R26: Xレジスタ下位バイト
-// R27: Xレジスタ上位バイト
-// R28: Yレジスタ下位バイト
-// R29: Yレジスタ上位バイト
-// R30: Zレジスタ下位バイト
-// R31: Zレジスタ上位バイト
-// SP_H: スタックポインタ上位バイト(0x3e)
-// SP_L: スタックポインタ下位バイト(0x3d)
-// SREG: ステータスレジスタ
-// ************************************************************
-inline void PortSaveContext(void) __attribute__((__always_inline__));
-inline void PortSaveContext(void)
-{
-    asm volatile(
-        "push   r0                          \n\t"
-        "in     r0, __SREG__                \n\t"
-        "cli                                \n\t"
-        "push   r0                          \n\t"
-        );
-
-#if defined(__AVR_HAVE_RAMPZ__)
-    // have RAMPZ Extended Z-pointer Register for ELPM/SPM
-    // the uC have extend program memory
-    // 0x3b --> RAMPZ
-    // 0x3c --> EIND
-    //
-    // RAMPZレジスタ, EINDレジスタを持つCPUには, これらレジスタの値も保存する.
-    //
-    // memo:
-    //  AVRマイコンでは, 年々メモリの容量が増加しており, アドレス16ビットではメモリすべてのアドレス
-    //  を示すことができなくなってきた. このような問題に対処するため,
-    //  Zレジスタを拡張するRAMPZ, EINDレジスタが導入された.
-    asm volatile(
-        "in     r0, 0x3b                    \n\t"
-        "push   r0                          \n\t"
-        "in     r0, 0x3c                    \n\t"
-        "push   r0                          \n\t"
-        );
-#endif
-    asm volatile(
-        "push   r1                          \n\t"
-        "clr    r1                          \n\t"
-        "push   r2                          \n\t"
-        "push   r3                          \n\t"
-        "push   r4                          \n\t"
-        "push   r5                          \n\t"
-        "push   r6                          \n\t"
-        "push   r7                          \n\t"
-        "push   r8                          \n\t"
-        "push   r9                          \n\t"
-        "push   r10                         \n\t"
-        "push   r11                         \n\t"
-        "push   r12                         \n\t"
-        "push   r13                         \n\t"
-        "push   r14                         \n\t"
-        "push   r15                         \n\t"
-        "push   r16                         \n\t"
-        "push   r17                         \n\t"
-        "push   r18                         \n\t"
-        "push   r19                         \n\t"
-        "push   r20                         \n\t"
-        "push   r21                         \n\t"
-        "push   r22                         \n\t"
-        "push   r23                         \n\t"
-        "push   r24                         \n\t"
-        "push   r25                         \n\t"
-        "push   r26                         \n\t"
-        "push   r27                         \n\t"
-        "push   r28                         \n\t"
-        "push   r29                         \n\t"
-        "push   r30                         \n\t"
-        "push   r31                         \n\t"
-        "lds    r26, currentTCB             \n\t"
-        "lds    r27, currentTCB + 1         \n\t"
-        "in     r0, 0x3d                    \n\t"
-        "st     x+, r0                      \n\t"
-        "in     r0, 0x3e                    \n\t"
-        "st     x+, r0                      \n\t"
-        );
-
-}
-
-// PortSaveContext()と逆のことをする.
-// 割り込みはPortSaveContext()で停止済み.
-//
-// Opposite to PortSaveContext().
-// Interrupts will have been disabled during the context save so we can write to the stack pointer.
-inline void PortRestoreContext(void) __attribute__((__always_inline__));
-inline void PortRestoreContext(void)
-{
-    asm volatile(
-        "lds    r26, currentTCB             \n\t"
-        "lds    r27, currentTCB + 1         \n\t"
-        "ld     r28, x+                     \n\t"
-        "out    __SP_L__, r28               \n\t"
-        "ld     r29, x+                     \n\t"
-        "out    __SP_H__, r29               \n\t"
-        "pop    r31                         \n\t"
-        "pop    r30                         \n\t"
-        "pop    r29                         \n\t"
-        "pop    r28                         \n\t"
-        "pop    r27                         \n\t"
-        "pop    r26                         \n\t"
-        "pop    r25                         \n\t"
-        "pop    r24                         \n\t"
-        "pop    r23                         \n\t"
-        "pop    r22                         \n\t"
-        "pop    r21                         \n\t"
-        "pop    r20                         \n\t"
-        "pop    r19                         \n\t"
-        "pop    r18                         \n\t"
-        "pop    r17                         \n\t"
-        "pop    r16                         \n\t"
-        "pop    r15                         \n\t"
-        "pop    r14                         \n\t"
-        "pop    r13                         \n\t"
-        "pop    r12                         \n\t"
-        "pop    r11                         \n\t"
-        "pop    r10                         \n\t"
-        "pop    r9                          \n\t"
-        "pop    r8                          \n\t"
-        "pop    r7                          \n\t"
-        "pop    r6                          \n\t"
-        "pop    r5                          \n\t"
-        "pop    r4                          \n\t"
-        "pop    r3                          \n\t"
-        "pop    r2                          \n\t"
-        "pop    r1                          \n\t"
-        "pop    r0                          \n\t"
-        );
-
-#if defined(__AVR_HAVE_RAMPZ__)
-    // have RAMPZ Extended Z-pointer Register for ELPM/SPM
-    // the uC have extend program memory
-    // 0x3b --> RAMPZ
-    // 0x3c --> EIND
-    asm volatile(
-        "out    0x3c, r0                    \n\t"
-        "pop    r0                          \n\t"
-        "out    0x3b, r0                    \n\t"
-        "pop    r0                          \n\t"
-        );
+#if (CONFIG_USE_ISR_STACK == 1)
+// 割り込み専用スタック. AVRのスタックポインタは次に積む位置を指すため,
+// 先頭は配列の最後の要素になる.
+unsigned char isrStack[CONFIG_ISR_STACK_SIZE];
+unsigned char * const isrStackTop = &isrStack[CONFIG_ISR_STACK_SIZE - 1];
+volatile unsigned char isrStackNesting = 0;
 #endif
 
-    asm volatile(
-        "out    __SREG__, r0                \n\t"
-        "pop    r0                          \n\t"
-        );
-}
+// ISR_WITH_YIELD()で宣言した割り込み関数の終わりでコンテキストスイッチを行うかどうか.
+// PortYieldFromISR()で設定される.
+volatile unsigned char isrYieldPending = 0;
 
-// Perfome hardware setup to enable ticks from timer 0, compare match A.
+// Perfome hardware setup to enable ticks from the timer selected by CONFIG_TICK_SOURCE.
 static void SetupTimerInterrupt( void );
 
 PortStackType *PortInitialiseStack(PortStackType *topOfStack, TaskCode code, void *parameters)
@@ -484,6 +327,7 @@ void PortYield(void) __attribute__((naked));
 void PortYield(void)
 {
     PortSaveContext();
+    PortSwitchToIsrStack();
     TaskSwitchContext();
     PortRestoreContext();
 
@@ -499,6 +343,7 @@ void PortYieldFromTick(void) __attribute__((naked));
 void PortYieldFromTick(void)
 {
     PortSaveContext();
+    PortSwitchToIsrStack();
     TaskIncrementTick();
     TaskSwitchContext();
     PortRestoreContext();
@@ -514,7 +359,10 @@ void PortYieldFromTick(void)
 //  クロック周波数: 16Mhz
 //   Timer割り込み周波数: 16Mhz / (256 * 64) = 976.5625 Hz
 //
-// Setup timer 0 compare match A to generate a tick interrupt.
+// CONFIG_TICK_SOURCE が PORT_TICK_SOURCE_TIMER1, PORT_TICK_SOURCE_TIMER2 のとき:
+//  tick割り込み周波数: F_CPU / (分周 * (PORT_TICK_TIMER_COMPARE + 1)) = CONFIG_TICK_RATE_HZ
+//
+// Setup timer 0 overflow, or timer 1/2 compare match A, to generate a tick interrupt.
 static void SetupTimerInterrupt( void )
 {
     // On the ATmega168, timer 0 is also used for fast hardware pwm
@@ -548,6 +396,7 @@ static void SetupTimerInterrupt( void )
     #error Timer 0 prescale factor 64 not set correctry
 #endif
 
+#if (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER0)
     // enable timer 0 overflow interrupt
 #if defined(TIMSK) && defined(TOIE0)
     sbi(TIMSK, TOIE0);
@@ -556,13 +405,80 @@ static void SetupTimerInterrupt( void )
 #else
     #error Timer 0 overflow interrupt not set correctly
 #endif
+
+#elif (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER1)
+    // Timer0はPWM(とmicros()以外の用途)のために動かしたままにし, 割り込みは使用しない.
+    //
+    // CTCモード(WGM12)で0からPORT_TICK_TIMER_COMPAREまでカウントし, コンペアマッチAでtickを発生させる.
+    //  例) 16Mhz, 1000Hz: 分周1, 比較値15999
+#if defined(TCCR1B) && defined(WGM12) && defined(TIMSK1)
+    TCCR1A = 0;
+    TCCR1B = 0;
+    TCNT1 = 0;
+    OCR1A = (unsigned int)PORT_TICK_TIMER_COMPARE;
+
+    switch (PORT_TICK_TIMER_PRESCALER)
+    {
+    case 1UL:   TCCR1B = _BV(WGM12) | _BV(CS10); break;
+    case 8UL:   TCCR1B = _BV(WGM12) | _BV(CS11); break;
+    case 64UL:  TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10); break;
+    case 256UL: TCCR1B = _BV(WGM12) | _BV(CS12); break;
+    default:    TCCR1B = _BV(WGM12) | _BV(CS12) | _BV(CS10); break;
+    }
+
+    sbi(TIFR1, OCF1A);
+    sbi(TIMSK1, OCIE1A);
+#else
+    #error Timer 1 CTC tick is not supported on this CPU
+#endif
+
+#elif (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER2)
+    // Timer2(8bit)のCTCモード(WGM21).
+    //  例) 16Mhz, 1000Hz: 分周64, 比較値249
+#if defined(TCCR2A) && defined(WGM21) && defined(TIMSK2)
+    TCCR2A = _BV(WGM21);
+    TCCR2B = 0;
+    TCNT2 = 0;
+    OCR2A = (unsigned char)PORT_TICK_TIMER_COMPARE;
+
+    // Timer2の分周の選択肢はTimer0, Timer1と異なる.
+    switch (PORT_TICK_TIMER_PRESCALER)
+    {
+    case 1UL:   TCCR2B = _BV(CS20); break;
+    case 8UL:   TCCR2B = _BV(CS21); break;
+    case 32UL:  TCCR2B = _BV(CS21) | _BV(CS20); break;
+    case 64UL:  TCCR2B = _BV(CS22); break;
+    case 128UL: TCCR2B = _BV(CS22) | _BV(CS20); break;
+    case 256UL: TCCR2B = _BV(CS22) | _BV(CS21); break;
+    default:    TCCR2B = _BV(CS22) | _BV(CS21) | _BV(CS20); break;
+    }
+
+    sbi(TIFR2, OCF2A);
+    sbi(TIMSK2, OCIE2A);
+#else
+    #error Timer 2 CTC tick is not supported on this CPU
+#endif
+
+#else
+    #error CONFIG_TICK_SOURCE must be PORT_TICK_SOURCE_TIMER0, PORT_TICK_SOURCE_TIMER1 or PORT_TICK_SOURCE_TIMER2
+#endif
 }
 
+// CTCモードのtickはコンペアマッチA割り込みで発生する.
+#if (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER1)
+    #define PORT_TICK_VECTOR TIMER1_COMPA_vect
+#elif (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER2)
+    #define PORT_TICK_VECTOR TIMER2_COMPA_vect
+#endif
+
 #if CONFIG_USE_PREEMPTION == 1
 // Tick ISR(Interrupt Service Routine) for preemptive scheduler. We can use a naked attribute as
 // the context is saved at the start of PortYieldFromTick(). The tick count
 // is incremented after the context is saved.
-    #if defined(__AVR_ATtiny24__) || defined(__AVR_ATtiny44__) || defined(__AVR_ATtiny84)
+    #if defined(PORT_TICK_VECTOR)
+        void PORT_TICK_VECTOR(void) __attribute__((signal, __INTR_ATTRS, naked));
+        void PORT_TICK_VECTOR(void)
+    #elif defined(__AVR_ATtiny24__) || defined(__AVR_ATtiny44__) || defined(__AVR_ATtiny84)
         void TIM0_OVF_vect(void) __attribute__((signal, __INTR_ATTRS, naked));
         void TIM0_OVF_vect(void)
     #else
@@ -577,7 +493,14 @@ static void SetupTimerInterrupt( void )
 #else
 // Tick ISR(Interrupt Service Routine) for the cooperative scheduler. All this does is increment
 // the tick count. We do't need to switch context, this can only be done by manual calls to TaskYield()
-    #if defined(__AVR_ATtiny24__) || defined(__AVR_ATtiny44__) || defined(__AVR_ATtiny84)
+    #if (CONFIG_USE_ISR_STACK == 1) && defined(PORT_TICK_VECTOR)
+        ISR_ON_ISR_STACK(PORT_TICK_VECTOR)
+    #elif (CONFIG_USE_ISR_STACK == 1)
+        ISR_ON_ISR_STACK(TIMER0_OVF_vect)
+    #elif defined(PORT_TICK_VECTOR)
+        void PORT_TICK_VECTOR(void) __attribute__((signal, __INTR_ATTRS));
+        void PORT_TICK_VECTOR(void)
+    #elif defined(__AVR_ATtiny24__) || defined(__AVR_ATtiny44__) || defined(__AVR_ATtiny84)
         void TIM0_OVF_vect(void) __attribute__((signal, __INTR_ATTRS));
         void TIM0_OVF_vext(void)
     #else
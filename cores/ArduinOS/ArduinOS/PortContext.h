@@ -0,0 +1,214 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+
+/*
+// AVRマイコン用 コンテキストの保存と復元
+//
+// Port.cのPortYield(), tick割り込みと, ISR_WITH_YIELD()で宣言した割り込み関数で使用されます.
+// nakedな関数の中でだけ使用してください.
+*/
+
+#ifndef ARDUINOS_PORTCONTEXT_H
+#define ARDUINOS_PORTCONTEXT_H
+
+#ifndef ARDUINOS_H
+    #error "include ArduinOS.h" must appear in source files before "include PortContext.h"
+#endif
+
+#if (CONFIG_USE_ISR_STACK == 1)
+// コンテキストを保存した後, カーネルの処理(TaskSwitchContext()など)を
+// 割り込み専用スタックで行う. 新しいスタックポインタはPortRestoreContext()で
+// TCBから読み込まれるため, 元に戻す必要はない.
+//
+// Switch to the ISR stack once the context has been saved. Interrupts are
+// disabled by the context save.
+#define PortSwitchToIsrStack()                          \
+    asm volatile(                                       \
+        "lds    r0, isrStackTop             \n\t"       \
+        "out    __SP_L__, r0                \n\t"       \
+        "lds    r0, isrStackTop + 1         \n\t"       \
+        "out    __SP_H__, r0                \n\t"       \
+        )
+#else
+#define PortSwitchToIsrStack()
+#endif
+
+// 汎用レジスタの保存, スタックポインタをTCBに保存
+//
+// まずやることはフラグの保存(ステータスレジスタの保存)そのあと割り込み停止である.
+//
+// Macro to save all the general purpose registers, the save the stack pointer into the TCB.
+// 
+// The first thing we do is save the flags then disable interrupts.
+// This is to guard our stack against having a contex switch interrupt after we have already
+// pushed the resisters onto the stack - causing the 32 registers to be on the stack twice.
+//
+// r1 is set to zero as the compiler expects it to be thus, 
+// however some of the math routines make use of r1.
+//
+// The interupts will have been disabled during the call to PortSaveContext()
+// so we need not worry about reading/writing to the stack pointer.
+// 
+// *** Memo ***************************************************
+// x: Xレジスタ(R26 : R27)
+// R26: Xレジスタ下位バイト
+// R27: Xレジスタ上位バイト
+// R28: Yレジスタ下位バイト
+// R29: Yレジスタ上位バイト
+// R30: Zレジスタ下位バイト
+// R31: Zレジスタ上位バイト
+// SP_H: スタックポインタ上位バイト(0x3e)
+// SP_L: スタックポインタ下位バイト(0x3d)
+// SREG: ステータスレジスタ
+// ************************************************************
+static inline void PortSaveContext(void) __attribute__((__always_inline__));
+static inline void PortSaveContext(void)
+{
+    asm volatile(
+        "push   r0                          \n\t"
+        "in     r0, __SREG__                \n\t"
+        "cli                                \n\t"
+        "push   r0                          \n\t"
+        );
+
+#if defined(__AVR_HAVE_RAMPZ__)
+    // have RAMPZ Extended Z-pointer Register for ELPM/SPM
+    // the uC have extend program memory
+    // 0x3b --> RAMPZ
+    // 0x3c --> EIND
+    //
+    // RAMPZレジスタ, EINDレジスタを持つCPUには, これらレジスタの値も保存する.
+    //
+    // memo:
+    //  AVRマイコンでは, 年々メモリの容量が増加しており, アドレス16ビットではメモリすべてのアドレス
+    //  を示すことができなくなってきた. このような問題に対処するため,
+    //  Zレジスタを拡張するRAMPZ, EINDレジスタが導入された.
+    asm volatile(
+        "in     r0, 0x3b                    \n\t"
+        "push   r0                          \n\t"
+        "in     r0, 0x3c                    \n\t"
+        "push   r0                          \n\t"
+        );
+#endif
+    asm volatile(
+        "push   r1                          \n\t"
+        "clr    r1                          \n\t"
+        "push   r2                          \n\t"
+        "push   r3                          \n\t"
+        "push   r4                          \n\t"
+        "push   r5                          \n\t"
+        "push   r6                          \n\t"
+        "push   r7                          \n\t"
+        "push   r8                          \n\t"
+        "push   r9                          \n\t"
+        "push   r10                         \n\t"
+        "push   r11                         \n\t"
+        "push   r12                         \n\t"
+        "push   r13                         \n\t"
+        "push   r14                         \n\t"
+        "push   r15                         \n\t"
+        "push   r16                         \n\t"
+        "push   r17                         \n\t"
+        "push   r18                         \n\t"
+        "push   r19                         \n\t"
+        "push   r20                         \n\t"
+        "push   r21                         \n\t"
+        "push   r22                         \n\t"
+        "push   r23                         \n\t"
+        "push   r24                         \n\t"
+        "push   r25                         \n\t"
+        "push   r26                         \n\t"
+        "push   r27                         \n\t"
+        "push   r28                         \n\t"
+        "push   r29                         \n\t"
+        "push   r30                         \n\t"
+        "push   r31                         \n\t"
+        "lds    r26, currentTCB             \n\t"
+        "lds    r27, currentTCB + 1         \n\t"
+        "in     r0, 0x3d                    \n\t"
+        "st     x+, r0                      \n\t"
+        "in     r0, 0x3e                    \n\t"
+        "st     x+, r0                      \n\t"
+        );
+
+}
+
+// PortSaveContext()と逆のことをする.
+// 割り込みはPortSaveContext()で停止済み.
+//
+// Opposite to PortSaveContext().
+// Interrupts will have been disabled during the context save so we can write to the stack pointer.
+static inline void PortRestoreContext(void) __attribute__((__always_inline__));
+static inline void PortRestoreContext(void)
+{
+    asm volatile(
+        "lds    r26, currentTCB             \n\t"
+        "lds    r27, currentTCB + 1         \n\t"
+        "ld     r28, x+                     \n\t"
+        "out    __SP_L__, r28               \n\t"
+        "ld     r29, x+                     \n\t"
+        "out    __SP_H__, r29               \n\t"
+        "pop    r31                         \n\t"
+        "pop    r30                         \n\t"
+        "pop    r29                         \n\t"
+        "pop    r28                         \n\t"
+        "pop    r27                         \n\t"
+        "pop    r26                         \n\t"
+        "pop    r25                         \n\t"
+        "pop    r24                         \n\t"
+        "pop    r23                         \n\t"
+        "pop    r22                         \n\t"
+        "pop    r21                         \n\t"
+        "pop    r20                         \n\t"
+        "pop    r19                         \n\t"
+        "pop    r18                         \n\t"
+        "pop    r17                         \n\t"
+        "pop    r16                         \n\t"
+        "pop    r15                         \n\t"
+        "pop    r14                         \n\t"
+        "pop    r13                         \n\t"
+        "pop    r12                         \n\t"
+        "pop    r11                         \n\t"
+        "pop    r10                         \n\t"
+        "pop    r9                          \n\t"
+        "pop    r8                          \n\t"
+        "pop    r7                          \n\t"
+        "pop    r6                          \n\t"
+        "pop    r5                          \n\t"
+        "pop    r4                          \n\t"
+        "pop    r3                          \n\t"
+        "pop    r2                          \n\t"
+        "pop    r1                          \n\t"
+        "pop    r0                          \n\t"
+        );
+
+#if defined(__AVR_HAVE_RAMPZ__)
+    // have RAMPZ Extended Z-pointer Register for ELPM/SPM
+    // the uC have extend program memory
+    // 0x3b --> RAMPZ
+    // 0x3c --> EIND
+    asm volatile(
+        "out    0x3c, r0                    \n\t"
+        "pop    r0                          \n\t"
+        "out    0x3b, r0                    \n\t"
+        "pop    r0                          \n\t"
+        );
+#endif
+
+    asm volatile(
+        "out    __SREG__, r0                \n\t"
+        "pop    r0                          \n\t"
+        );
+}
+
+#endif
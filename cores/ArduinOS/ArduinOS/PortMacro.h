@@ -93,6 +93,11 @@ mission critical applications that require provable dependability.
 #ifndef ARDUINOS_PORTMACRO_H
 #define ARDUINOS_PORTMACRO_H
 
+#if defined(CONFIG_USE_CRITICAL_PROFILER) && (CONFIG_USE_CRITICAL_PROFILER == 1)
+    // PSTR()
+    #include <avr/pgmspace.h>
+#endif
+
 // C言語でコンパイルするように宣言
 // 関数が正しくリンクされるようにするため.
 #ifdef __cplusplus
@@ -118,6 +123,19 @@ extern "C" {
     // -------------------------------------------------------------------
 
     // --- Critical section management -----------------------------------
+#if defined(CONFIG_USE_CRITICAL_PROFILER) && (CONFIG_USE_CRITICAL_PROFILER == 1)
+    // 割り込み禁止時間を測定する版(CriticalProfiler.h).
+    // 呼び出し元のファイルと行を記録するため, 関数呼び出しになります.
+    // SREGはこれまでと同じくスタックに積まれます.
+    extern unsigned char CriticalProfilerEnter(const char *file, unsigned short line);
+    extern void CriticalProfilerExit(unsigned char sreg);
+
+#define PortEnterCritical() \
+    asm volatile ("push     %0" :: "r" (CriticalProfilerEnter(PSTR(__FILE__), __LINE__)))
+
+#define PortExitCritical() \
+    CriticalProfilerExit(({ unsigned char sreg; asm volatile ("pop      %0" : "=r" (sreg)); sreg; }))
+#else
 #define PortEnterCritical() \
     asm volatile ("in       __tmp_reg__, __SREG__"::);\
     asm volatile ("cli":: );\
@@ -126,6 +144,7 @@ extern "C" {
 #define PortExitCritical() \
     asm volatile ("pop      __tmp_reg__"::);\
     asm volatile ("out      __SREG__, __tmp_reg__"::)
+#endif
 
 #define PortDisableInterrupts() \
     asm volatile ("cli"::);
@@ -151,6 +170,48 @@ extern "C" {
 //
 #define PORT_TICK_RATE_MS ((PortTickType) 1000 / CONFIG_TICK_RATE_HZ)
 
+// ms を tick に変換する.
+// CONFIG_TICK_RATE_HZ が1000より大きいとき PORT_TICK_RATE_MS は0になるため, こちらを使用する.
+#define PORT_MILLIS_TO_TICKS(ms)                                                    \
+    ((CONFIG_TICK_RATE_HZ >= 1000) ?                                                \
+        ((PortTickType)(ms) * (PortTickType)(CONFIG_TICK_RATE_HZ / 1000)) :         \
+        ((PortTickType)(ms) / (PortTickType)(1000 / CONFIG_TICK_RATE_HZ)))
+
+// tick割り込みを発生させるタイマー(CONFIG_TICK_SOURCE)
+//  PORT_TICK_SOURCE_TIMER0:
+//   Timer0のオーバーフロー. 分周64固定のため, 16Mhzでは976.5625Hzになる.
+//  PORT_TICK_SOURCE_TIMER1, PORT_TICK_SOURCE_TIMER2:
+//   CTCモードのコンペアマッチA. 比較値はF_CPUとCONFIG_TICK_RATE_HZから計算され,
+//   F_CPUがCONFIG_TICK_RATE_HZで割り切れればtickは正確になる.
+//   Timer0はPWM専用になり, 代わりにtickに使用したタイマーのPWMピンは使用できなくなる.
+#define PORT_TICK_SOURCE_TIMER0 0
+#define PORT_TICK_SOURCE_TIMER1 1
+#define PORT_TICK_SOURCE_TIMER2 2
+
+// 1tickあたりのCPUクロック数
+#define PORT_TICK_TIMER_CYCLES ((unsigned long)F_CPU / (unsigned long)CONFIG_TICK_RATE_HZ)
+
+// 比較値がタイマーの範囲に収まる最小の分周
+#define PORT_TIMER1_TICK_PRESCALER                                  \
+    ((PORT_TICK_TIMER_CYCLES <= 65536UL) ? 1UL :                    \
+    (PORT_TICK_TIMER_CYCLES <= (65536UL * 8UL)) ? 8UL :             \
+    (PORT_TICK_TIMER_CYCLES <= (65536UL * 64UL)) ? 64UL :           \
+    (PORT_TICK_TIMER_CYCLES <= (65536UL * 256UL)) ? 256UL : 1024UL)
+
+#define PORT_TIMER2_TICK_PRESCALER                                  \
+    ((PORT_TICK_TIMER_CYCLES <= 256UL) ? 1UL :                      \
+    (PORT_TICK_TIMER_CYCLES <= (256UL * 8UL)) ? 8UL :               \
+    (PORT_TICK_TIMER_CYCLES <= (256UL * 32UL)) ? 32UL :             \
+    (PORT_TICK_TIMER_CYCLES <= (256UL * 64UL)) ? 64UL :             \
+    (PORT_TICK_TIMER_CYCLES <= (256UL * 128UL)) ? 128UL :           \
+    (PORT_TICK_TIMER_CYCLES <= (256UL * 256UL)) ? 256UL : 1024UL)
+
+#define PORT_TICK_TIMER_PRESCALER                                   \
+    ((CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER1) ? PORT_TIMER1_TICK_PRESCALER : PORT_TIMER2_TICK_PRESCALER)
+
+// OCRxAに設定する比較値. タイマーは0からこの値までカウントする.
+#define PORT_TICK_TIMER_COMPARE ((PORT_TICK_TIMER_CYCLES / PORT_TICK_TIMER_PRESCALER) - 1UL)
+
 #define PORT_BYTE_ALIGNMENT 1
 #define PortNop() asm volatile ("nop");
 // -------------------------------------------------------------------
@@ -158,6 +219,170 @@ extern "C" {
 // ---Kernel utilities -----------------------------------------------
     extern void PortYield(void) __attribute__((naked));
 
+// -------------------------------------------------------------------
+
+// --- ISR stack -----------------------------------------------------
+//
+// CONFIG_USE_ISR_STACK が1のとき, Port.cで割り込み専用のスタックが確保されます.
+//
+// 割り込み関数の入口(PortIsrStackEnter)ではr0, SREG, r28, r29だけを割り込まれた
+// タスクのスタックに積み, スタックポインタを割り込み専用スタックの先頭に切り替えます.
+// 呼び出し先で壊されるレジスタ(r1, r18-r27, r30, r31, RAMPZ)は割り込み専用スタックに保存されます.
+// 出口(PortIsrStackExit)で元のスタックポインタに戻します.
+// isrStackNestingは割り込みのネストの深さで, 0のときだけスタックを切り替えます.
+//
+    extern volatile unsigned char isrStackNesting;
+    extern unsigned char * const isrStackTop;
+
+#if defined(__AVR_HAVE_RAMPZ__)
+#define PORT_ISR_STACK_SAVE_RAMPZ                       \
+        "in     r0, 0x3b                    \n\t"       \
+        "push   r0                          \n\t"
+#define PORT_ISR_STACK_RESTORE_RAMPZ                    \
+        "pop    r0                          \n\t"       \
+        "out    0x3b, r0                    \n\t"
+#else
+#define PORT_ISR_STACK_SAVE_RAMPZ
+#define PORT_ISR_STACK_RESTORE_RAMPZ
+#endif
+
+#define PortIsrStackEnter()                             \
+    asm volatile(                                       \
+        "push   r0                          \n\t"       \
+        "in     r0, __SREG__                \n\t"       \
+        "push   r0                          \n\t"       \
+        "push   r28                         \n\t"       \
+        "push   r29                         \n\t"       \
+        "in     r28, __SP_L__               \n\t"       \
+        "in     r29, __SP_H__               \n\t"       \
+        "lds    r0, isrStackNesting         \n\t"       \
+        "inc    r0                          \n\t"       \
+        "sts    isrStackNesting, r0         \n\t"       \
+        "dec    r0                          \n\t"       \
+        "brne   1f                          \n\t"       \
+        "lds    r0, isrStackTop             \n\t"       \
+        "out    __SP_L__, r0                \n\t"       \
+        "lds    r0, isrStackTop + 1         \n\t"       \
+        "out    __SP_H__, r0                \n\t"       \
+        "1:                                 \n\t"       \
+        "push   r28                         \n\t"       \
+        "push   r29                         \n\t"       \
+        "push   r1                          \n\t"       \
+        "clr    r1                          \n\t"       \
+        "push   r18                         \n\t"       \
+        "push   r19                         \n\t"       \
+        "push   r20                         \n\t"       \
+        "push   r21                         \n\t"       \
+        "push   r22                         \n\t"       \
+        "push   r23                         \n\t"       \
+        "push   r24                         \n\t"       \
+        "push   r25                         \n\t"       \
+        "push   r26                         \n\t"       \
+        "push   r27                         \n\t"       \
+        "push   r30                         \n\t"       \
+        "push   r31                         \n\t"       \
+        PORT_ISR_STACK_SAVE_RAMPZ                       \
+        )
+
+#define PortIsrStackExit()                              \
+    asm volatile(                                       \
+        PORT_ISR_STACK_RESTORE_RAMPZ                    \
+        "pop    r31                         \n\t"       \
+        "pop    r30                         \n\t"       \
+        "pop    r27                         \n\t"       \
+        "pop    r26                         \n\t"       \
+        "pop    r25                         \n\t"       \
+        "pop    r24                         \n\t"       \
+        "pop    r23                         \n\t"       \
+        "pop    r22                         \n\t"       \
+        "pop    r21                         \n\t"       \
+        "pop    r20                         \n\t"       \
+        "pop    r19                         \n\t"       \
+        "pop    r18                         \n\t"       \
+        "pop    r1                          \n\t"       \
+        "pop    r29                         \n\t"       \
+        "pop    r28                         \n\t"       \
+        "lds    r0, isrStackNesting         \n\t"       \
+        "dec    r0                          \n\t"       \
+        "sts    isrStackNesting, r0         \n\t"       \
+        "cli                                \n\t"       \
+        "out    __SP_H__, r29               \n\t"       \
+        "out    __SP_L__, r28               \n\t"       \
+        "pop    r29                         \n\t"       \
+        "pop    r28                         \n\t"       \
+        "pop    r0                          \n\t"       \
+        "out    __SREG__, r0                \n\t"       \
+        "pop    r0                          \n\t"       \
+        "reti                               \n\t"       \
+        )
+
+// 割り込み関数の本体を通常の関数として定義し, 割り込み専用スタック上で呼び出す.
+// 本体がnakedな割り込み関数にインライン展開されると呼び出し先保存レジスタが
+// 保存されないため, noinlineにする.
+#define PORT_ISR_ON_ISR_STACK(vector)                                   \
+    static void vector##_IsrBody(void) __attribute__((noinline));       \
+    ISR(vector, ISR_NAKED)                                              \
+    {                                                                   \
+        PortIsrStackEnter();                                            \
+        vector##_IsrBody();                                             \
+        PortIsrStackExit();                                             \
+    }                                                                   \
+    static void vector##_IsrBody(void)
+
+// -------------------------------------------------------------------
+
+// --- Yield from ISR ------------------------------------------------
+//
+// PORT_ISR_WITH_YIELD()で宣言した割り込み関数は, 入口で割り込まれたタスクの
+// コンテキストをすべて保存し(PortSaveContext), 本体を呼び出します.
+// 本体でPortYieldFromISR()が呼ばれていれば, 出口でTaskSwitchContext()を呼び,
+// 起床した優先度の高いタスクに直接戻ります. 次のtickまで待つ必要はありません.
+//
+// PortSaveContext()などはPortContext.hで定義されます.
+//
+    extern volatile unsigned char isrYieldPending;
+
+#define PortYieldFromISR(switchRequired)                \
+    do                                                  \
+    {                                                   \
+        if (switchRequired)                             \
+        {                                               \
+            isrYieldPending = 1;                        \
+        }                                               \
+    } while (0)
+
+// 本体は通常の関数として呼び出す(PORT_ISR_ON_ISR_STACKと同じ理由でnoinline).
+// 割り込み関数の中ではレジスタはすべて保存済みのため, 本体の戻り後は
+// 呼び出し先で壊されるレジスタを自由に使ってよい.
+//
+// tick割り込み(PortYieldFromTick())と同じく, コンテキストの保存から切り替えまでを
+// nakedな関数(vector##_Yield)で行い, retで割り込み関数に戻ってからretiする.
+// 割り込みで保存したフレーム(SREGのIは0)は, PortYield()などから再開されても
+// 必ずこのretiを通るため, 割り込みが禁止されたまま再開されることはない.
+// また, PortYield()で保存したフレームは保存時のSREGのままretで再開される.
+#define PORT_ISR_WITH_YIELD(vector)                                     \
+    static void vector##_YieldBody(void) __attribute__((noinline));     \
+    static void vector##_Yield(void) __attribute__((naked, noinline));  \
+    static void vector##_Yield(void)                                    \
+    {                                                                   \
+        PortSaveContext();                                              \
+        PortSwitchToIsrStack();                                         \
+        vector##_YieldBody();                                           \
+        if (isrYieldPending)                                            \
+        {                                                               \
+            isrYieldPending = 0;                                        \
+            TaskSwitchContext();                                        \
+        }                                                               \
+        PortRestoreContext();                                           \
+        asm volatile("ret");                                            \
+    }                                                                   \
+    ISR(vector, ISR_NAKED)                                              \
+    {                                                                   \
+        vector##_Yield();                                               \
+        asm volatile("reti");                                           \
+    }                                                                   \
+    static void vector##_YieldBody(void)
+
 // -------------------------------------------------------------------
 
     // Task function macros
@@ -88,7 +88,11 @@ mission critical applications that require provable dependability.
 #ifndef ARDUINOS_PORTABLE_H
 #define ARDUINOS_PORTABLE_H
 
-#include "PortMacro.h"
+#if defined(ARDUINOS_PORT_POSIX)
+    #include "Posix/PortMacro.h"
+#else
+    #include "PortMacro.h"
+#endif
 
 #if PORT_BYTE_ALIGNMENT == 8
     #define PORT_BYTE_ALIGNMENT_MASK (0x0007)
@@ -118,6 +122,10 @@ extern "C" {
     // Setup the stack of anew task so it is readyto be placed under the
     // scheduler control. The registers have to be placed on the stack in
     // the order that the port expects to find them.
+    //
+    // X^bN̐擪Ԃ. |[g^XN̎sɕKvȂ̂
+    // mۂłȂƂNULLԂ, TaskCreate()͎s.
+    // (AVR̃|[gNULLԂȂ. zXgp̃|[gmalloc()̎sŕԂ.)
     PortStackType *PortInitialiseStack(PortStackType *topOfStack, TaskCode code, void *parameters);
 
     // Map to the memory management routines required for the port
@@ -0,0 +1,33 @@
+#ifndef ARDUINOS_CONFIG_POSIX_H
+#define ARDUINOS_CONFIG_POSIX_H
+
+// Memory
+// TaskCreate()のスタックはPortStackType(8byte)単位です.
+// タスクの実際のスタックはPosix/Port.cでPORT_POSIX_STACK_SIZE分確保されます.
+#define CONFIG_MINIMAL_STACK_SIZE ((unsigned short) 128)
+#define CONFIG_TOTAL_HEAP_SIZE ((size_t) (64 * 1024))
+
+// Timer
+#define CONFIG_USE_16_BIT_TICKS 0
+#define CONFIG_TICK_RATE_HZ ((PortTickType)1000)
+
+// Task
+#define CONFIG_MAX_TASK_NAME_LEN (8)
+
+// Hook
+// ApplicationTickHook()はArduinoコア(wiring.c)で定義されるため使用しない.
+#define CONFIG_USE_TICK_HOOK 0
+
+// Mutex
+#define CONFIG_USE_MUTEXES 1
+
+// -------------------------------------------------------------------------
+// Set the following definitions to 1 to include the API function, or zero
+// to wxclude the API function
+#define INCLUDE_TASK_DELETE 1
+#define INCLUDE_TASK_SUSPEND 1
+#define INCLUDE_TASK_DELAY 1
+#define INCLUDE_TASK_DELAY_UNTIL 1
+#define INCLUDE_TASK_GET_SCHEDULER_STATE 0
+
+#endif
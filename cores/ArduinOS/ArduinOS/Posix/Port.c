@@ -0,0 +1,330 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+
+/*
+// POSIX(Linux) ホスト用ポート
+//
+// カーネル(Task.c, Queue.c, List.c, Heap4.c など)をPC上で動かすためのポートです.
+// 実機やシミュレータを使わずに, スケジューリングやQueueの動作をテスト, デバッグできます.
+//
+//  コンテキスト:
+//   タスクごとにucontext_tとホスト側のスタック(PORT_POSIX_STACK_SIZE)を確保します.
+//   TCBのtopOfStackが指す要素にはこのコンテキストへのポインタが格納されます.
+//  tick:
+//   setitimer()によるSIGALRMをtick割り込みとして使用します(CONFIG_TICK_RATE_HZ).
+//  クリティカルセクション:
+//   割り込み禁止の代わりにSIGALRMをマスクします.
+//
+// ARDUINOS_PORT_POSIX を定義してコンパイルしてください. 例:
+//
+//  gcc -DARDUINOS_PORT_POSIX -I cores/ArduinOS/ArduinOS -o app \
+//      app.c cores/ArduinOS/ArduinOS/Task.c cores/ArduinOS/ArduinOS/Queue.c \
+//      cores/ArduinOS/ArduinOS/List.c cores/ArduinOS/ArduinOS/Heap4.c \
+//      cores/ArduinOS/ArduinOS/Posix/Port.c
+//
+// 制限:
+//  tick割り込み(シグナル)はタスクの任意の位置で発生するため, タスクから
+//  printf()などのリエントラントでないライブラリ関数を呼ぶときは
+//  クリティカルセクションかTaskSuspendAll()で保護してください.
+//  TaskEndScheduler()を呼ぶと, TaskStartScheduler()から戻ります.
+//  このとき削除されていないタスクのメモリは解放されません.
+*/
+
+#if defined(ARDUINOS_PORT_POSIX)
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <ucontext.h>
+#include <sys/time.h>
+
+#include "../ArduinOS.h"
+#include "../Task.h"
+
+// タスクごとのホスト側スタックのサイズ(byte).
+// TaskCreate()に渡すスタックサイズとは別に確保されます.
+#ifndef PORT_POSIX_STACK_SIZE
+    #define PORT_POSIX_STACK_SIZE (64UL * 1024UL)
+#endif
+
+// tick割り込みとして使うシグナル
+#define PORT_TICK_SIGNAL SIGALRM
+
+//
+// Host context of a task. A pointer to it is stored in the stack slot
+// returned by PortInitialiseStack(), which is where the TCB's topOfStack
+// points to.
+//
+typedef struct
+{
+    ucontext_t context;
+    void *stack;
+} PosixContext;
+
+// We require the address of the currentTCB variable, but don't want to know
+// any details of its type. topOfStack is the first member of the TCB.
+typedef void TaskControlBlock;
+extern volatile TaskControlBlock * volatile currentTCB;
+
+#define CURRENT_CONTEXT() (*(PosixContext **)(*(PortStackType **)currentTCB))
+
+// Context that called PortStartScheduler(). PortEndScheduler() returns here.
+static ucontext_t schedulerContext;
+static struct sigaction previousTickAction;
+
+// クリティカルセクションのネストの深さ.
+// AVRではSREGがタスクのスタックに積まれますが, ここではPortYield()の
+// ローカル変数としてタスクごとに保存されます.
+static volatile unsigned long criticalNesting = 0;
+
+static void TaskEntry(void);
+static void BlockTickSignal(sigset_t *previous);
+static void UnblockTickSignal(void);
+static void SwitchContext(void);
+static void TickSignalHandler(int signal);
+static void SetupTimerInterrupt(void);
+static void StopTimerInterrupt(void);
+
+// ------------------------------------------------------------------------
+// Implementation of function defined in Portable.h for the POSIX port.
+// ------------------------------------------------------------------------
+
+//
+// Entry point of every task. makecontext() can only pass int arguments,
+// so the task code and parameters are taken from the slots above the
+// context pointer.
+//
+static void TaskEntry(void)
+{
+    PortStackType *topOfStack = *(PortStackType **)currentTCB;
+    TaskCode code = (TaskCode)topOfStack[2];
+    void *parameters = (void *)topOfStack[1];
+
+    // Tasks start outside of any critical section with the tick enabled.
+    criticalNesting = 0;
+    UnblockTickSignal();
+
+    code(parameters);
+
+    // Task functions must not return.
+    for (;;)
+    {
+        TaskDelete(NULL);
+    }
+}
+
+// コンテキストとスタックを確保できなかったときはNULLを返し, TaskCreate()を失敗させる.
+PortStackType *PortInitialiseStack(PortStackType *topOfStack, TaskCode code, void *parameters)
+{
+    PosixContext *host;
+
+    host = (PosixContext *)malloc(sizeof(PosixContext));
+    if (host == NULL)
+    {
+        return NULL;
+    }
+
+    host->stack = malloc(PORT_POSIX_STACK_SIZE);
+    if (host->stack == NULL)
+    {
+        free(host);
+        return NULL;
+    }
+
+    getcontext(&host->context);
+    host->context.uc_stack.ss_sp = host->stack;
+    host->context.uc_stack.ss_size = PORT_POSIX_STACK_SIZE;
+    host->context.uc_link = NULL;
+
+    // Start with the tick blocked, TaskEntry() enables it.
+    sigemptyset(&host->context.uc_sigmask);
+    sigaddset(&host->context.uc_sigmask, PORT_TICK_SIGNAL);
+
+    makecontext(&host->context, TaskEntry, 0);
+
+    // タスクのスタックには, コードとパラメータ, コンテキストへのポインタを積む.
+    *topOfStack = (PortStackType)code;
+    topOfStack--;
+    *topOfStack = (PortStackType)parameters;
+    topOfStack--;
+    *topOfStack = (PortStackType)host;
+
+    return topOfStack;
+}
+
+void PortCleanUpTaskPosix(PortStackType *topOfStack)
+{
+    PosixContext *host = *(PosixContext **)topOfStack;
+
+    // The idle task deletes tasks, so the stack of the deleted task is no
+    // longer in use here.
+    free(host->stack);
+    free(host);
+}
+
+PortBaseType PortStartScheduler(void)
+{
+    sigset_t previousMask;
+    struct sigaction action;
+
+    // TaskStartScheduler()で割り込み(tick)は禁止済み.
+    BlockTickSignal(&previousMask);
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = TickSignalHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(PORT_TICK_SIGNAL, &action, &previousTickAction);
+
+    // Setup the timer to generate the tick.
+    SetupTimerInterrupt();
+
+    // Start the first task. PortEndScheduler() resumes here.
+    swapcontext(&schedulerContext, &CURRENT_CONTEXT()->context);
+
+    sigaction(PORT_TICK_SIGNAL, &previousTickAction, NULL);
+    criticalNesting = 0;
+    sigprocmask(SIG_SETMASK, &previousMask, NULL);
+
+    return PD_TRUE;
+}
+
+void PortEndScheduler(void)
+{
+    StopTimerInterrupt();
+
+    // TaskStartScheduler()を呼んだコンテキストに戻る.
+    setcontext(&schedulerContext);
+}
+
+// Manual context switch. The caller may be inside a critical section
+// (PortYieldWithinAPI()), so the nesting and signal mask of the caller are
+// kept on its own stack and restored when it runs again.
+void PortYield(void)
+{
+    sigset_t previousMask;
+    unsigned long nesting;
+
+    BlockTickSignal(&previousMask);
+    nesting = criticalNesting;
+
+    SwitchContext();
+
+    criticalNesting = nesting;
+    sigprocmask(SIG_SETMASK, &previousMask, NULL);
+}
+
+void PortEnterCriticalPosix(void)
+{
+    BlockTickSignal(NULL);
+    criticalNesting++;
+}
+
+void PortExitCriticalPosix(void)
+{
+    if (criticalNesting > 0)
+    {
+        criticalNesting--;
+        if (criticalNesting == 0)
+        {
+            UnblockTickSignal();
+        }
+    }
+}
+
+void PortDisableInterruptsPosix(void)
+{
+    BlockTickSignal(NULL);
+}
+
+void PortEnableInterruptsPosix(void)
+{
+    UnblockTickSignal();
+}
+
+static void BlockTickSignal(sigset_t *previous)
+{
+    sigset_t tick;
+
+    sigemptyset(&tick);
+    sigaddset(&tick, PORT_TICK_SIGNAL);
+    sigprocmask(SIG_BLOCK, &tick, previous);
+}
+
+static void UnblockTickSignal(void)
+{
+    sigset_t tick;
+
+    sigemptyset(&tick);
+    sigaddset(&tick, PORT_TICK_SIGNAL);
+    sigprocmask(SIG_UNBLOCK, &tick, NULL);
+}
+
+//
+// Select the next task and switch to it. Called with the tick blocked.
+//
+static void SwitchContext(void)
+{
+    PosixContext *from = CURRENT_CONTEXT();
+    PosixContext *to;
+
+    TaskSwitchContext();
+
+    to = CURRENT_CONTEXT();
+    if (from != to)
+    {
+        swapcontext(&from->context, &to->context);
+    }
+}
+
+//
+// Tick ISR. The signal is blocked while the handler runs. When the handler
+// switches to another task, the interrupted task stays inside the handler
+// until it is selected again, and the signal mask is restored on return.
+//
+static void TickSignalHandler(int signal)
+{
+    (void)signal;
+
+    TaskIncrementTick();
+
+    #if CONFIG_USE_PREEMPTION == 1
+    {
+        // A task can only be interrupted outside of a critical section.
+        SwitchContext();
+        criticalNesting = 0;
+    }
+    #endif
+}
+
+static void SetupTimerInterrupt(void)
+{
+    struct itimerval timer;
+
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = 1000000L / CONFIG_TICK_RATE_HZ;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+static void StopTimerInterrupt(void)
+{
+    struct itimerval timer;
+
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+#endif
@@ -0,0 +1,98 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+
+// ---------------------------------------------------------
+// Port specific definitions for the POSIX (Linux) host port.
+//
+// ARDUINOS_PORT_POSIX が定義されているとき, Portable.hからこのファイルが読み込まれます.
+// 詳しくはPosix/Port.cを参照してください.
+// ---------------------------------------------------------
+
+#ifndef ARDUINOS_PORTMACRO_H
+#define ARDUINOS_PORTMACRO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    // --- Type definitions --------------------------------------------
+#define PortChar char
+#define PortFloat float
+#define PortDouble double
+#define PortLong long
+#define PortShort short
+    // スタックの1要素にポインタを格納するため, ポインタと同じ大きさにする.
+#define PortStackType unsigned long
+#define PortBaseType long
+
+#if(CONFIG_USE_16_BIT_TICKS == 1)
+    typedef unsigned PortShort PortTickType;
+#define PORT_MAX_DELAY (PortTickType) 0xffff
+#else
+    typedef unsigned int PortTickType;
+#define PORT_MAX_DELAY (PortTickType) 0xffffffff
+#endif
+
+#define PortPointerSizeType unsigned long
+    // -------------------------------------------------------------------
+
+    // --- Critical section management -----------------------------------
+    //
+    // 割り込みの代わりにtickシグナル(SIGALRM)をマスクします.
+    // ネストの深さはタスクごとにコンテキストと一緒に保存されます.
+    //
+    extern void PortEnterCriticalPosix(void);
+    extern void PortExitCriticalPosix(void);
+    extern void PortDisableInterruptsPosix(void);
+    extern void PortEnableInterruptsPosix(void);
+
+#define PortEnterCritical() PortEnterCriticalPosix()
+#define PortExitCritical() PortExitCriticalPosix()
+#define PortDisableInterrupts() PortDisableInterruptsPosix()
+#define PortEnableInterrupts() PortEnableInterruptsPosix()
+    // -------------------------------------------------------------------
+
+    // --- Architecture specifics ----------------------------------------
+#define PORT_STACK_GROWTH (-1)
+
+#define PORT_TICK_RATE_MS ((PortTickType) 1000 / CONFIG_TICK_RATE_HZ)
+
+    // ms を tick に変換する.
+#define PORT_MILLIS_TO_TICKS(ms)                                                    \
+    ((CONFIG_TICK_RATE_HZ >= 1000) ?                                                \
+        ((PortTickType)(ms) * (PortTickType)(CONFIG_TICK_RATE_HZ / 1000)) :         \
+        ((PortTickType)(ms) / (PortTickType)(1000 / CONFIG_TICK_RATE_HZ)))
+
+#define PORT_BYTE_ALIGNMENT 8
+#define PortNop()
+    // -------------------------------------------------------------------
+
+    // ---Kernel utilities -----------------------------------------------
+    extern void PortYield(void);
+
+    // タスク削除時にホスト側のコンテキストとスタックを開放する.
+    extern void PortCleanUpTaskPosix(PortStackType *topOfStack);
+#define PortCleanUpTCB(tcb) PortCleanUpTaskPosix((PortStackType *)(tcb)->topOfStack)
+
+    // -------------------------------------------------------------------
+
+    // Task function macros
+#define PortTaskFunctionProto(function, parameters) void function(void *parameters)
+#define PortTaskFunction(function, parameters) void function(void *parameters)
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -99,7 +99,47 @@ mission critical applications that require provable dependability.
 #define isMutex head
 #define QUEUE_QUEUE_IS_MUTEX NULL
 
-typedef struct 
+#if (CONFIG_USE_PRIORITY_CEILING_MUTEXES == 1)
+    #define QUEUE_NO_CEILING ((unsigned PortBaseType)0xff)
+    #define QueueIsCeilingMutex(queue) (((queue)->ceilingPriority != QUEUE_NO_CEILING) ? PD_TRUE : PD_FALSE)
+#else
+    #define QueueIsCeilingMutex(queue) PD_FALSE
+#endif
+
+#if (CONFIG_USE_PRIORITY_QUEUES == 1)
+// Marks the end of a slot chain in a priority index.
+#define PRIORITY_QUEUE_NO_SLOT ((unsigned PortBaseType)0xffU)
+
+// Offset of the priority index from the head of the storage area. Rounded up
+// so that the index fields are aligned on ports where PortBaseType is wider
+// than a byte (the storage area itself is one byte longer than the items).
+#define PriorityIndexOffset(queueLength, itemSize)                                      \
+    (((size_t)((queueLength) * (itemSize)) + (size_t)1 + (sizeof(unsigned PortBaseType) - 1)) \
+     & ~(sizeof(unsigned PortBaseType) - 1))
+
+//
+// 優先度付きQueueの索引
+// アイテム格納領域の各スロットを, 優先度ごとのFIFOリストと空きリストに繋ぐ.
+// 送信時はスロットを一つ取り出して該当する優先度の末尾に繋ぐだけなので,
+// 格納領域内のアイテムを移動(memmove)する必要がない.
+//
+typedef struct
+{
+    // The oldest slot of each priority. PRIORITY_QUEUE_NO_SLOT if empty.
+    unsigned PortBaseType first[CONFIG_MAX_MESSAGE_PRIORITIES];
+
+    // The newest slot of each priority.
+    unsigned PortBaseType last[CONFIG_MAX_MESSAGE_PRIORITIES];
+
+    // The first unused slot.
+    unsigned PortBaseType freeSlot;
+
+    // The slot that follows each slot in its chain. One entry per queue item.
+    unsigned PortBaseType next[];
+}PriorityIndex;
+#endif
+
+typedef struct QueueDefinition
 {
     // Points to the beginning of the queue storage area.
     signed char *head;
@@ -136,8 +176,38 @@ typedef struct
     // Stores the number of items transmitted to the queue (added to the queue)
     // while the queue was locked. Set to QUEUE_UNLOCKED when the queue is not locked.
     volatile signed PortBaseType txLock;
+
+    #if (CONFIG_USE_PRIORITY_QUEUES == 1)
+        // Slot chains for a priority queue. NULL for every other queue type.
+        PriorityIndex *priorityIndex;
+    #endif
+
+    #if (CONFIG_USE_PRIORITY_CEILING_MUTEXES == 1)
+        // The priority the holder runs at while it holds the mutex.
+        // QUEUE_NO_CEILING for every queue other than a priority ceiling mutex.
+        unsigned PortBaseType ceilingPriority;
+
+        // The priority of the holder before it took the mutex.
+        unsigned PortBaseType holderPriority;
+    #endif
+
+    #if (CONFIG_USE_QUEUE_STATS == 1)
+        // Statistics used to size queues from measured data.
+        QueueStats stats;
+
+        // Optional name used to identify the queue when it is enumerated.
+        const signed char *name;
+
+        // The next queue in the registry.
+        struct QueueDefinition *nextRegistered;
+    #endif
 }Queue;
 
+#if (CONFIG_USE_QUEUE_STATS == 1)
+    // Head of the list of all queues that currently exist.
+    static Queue *queueRegistry = NULL;
+#endif
+
 /*
 // Unlocks a queue locked by a call to LockQueue.  Locking a queue does not
 // prevent an ISR from adding or removing items to the queue, but does prevent
@@ -175,6 +245,32 @@ static void CopyDataToQueue(Queue *queue, const void *itemToQueue, PortBaseType
 */
 static void CopyDataFromQueue(Queue *const queue, const void *buffer);
 
+#if (CONFIG_USE_PRIORITY_QUEUES == 1)
+/*
+// Puts every slot of a priority queue back on the free chain.
+*/
+static void InitialisePriorityIndex(Queue *queue);
+
+/*
+// Returns the slot holding the oldest item of the highest priority present.
+// The queue must not be empty.
+*/
+static unsigned PortBaseType GetHighestPrioritySlot(const Queue *queue, unsigned PortBaseType *priority);
+
+/*
+// Removes the item returned by GetHighestPrioritySlot() from the queue.
+*/
+static void RemoveHighestPriorityItem(Queue *queue);
+#endif
+
+#if (CONFIG_USE_QUEUE_STATS == 1)
+/*
+// Adds a newly created queue to, or removes a deleted queue from, the registry.
+*/
+static void AddQueueToRegistry(Queue *queue);
+static void RemoveQueueFromRegistry(Queue *queue);
+#endif
+
 
 //
 // Macro to mark a queue as locked. Locking a queue prevents an ISR from
@@ -194,6 +290,44 @@ static void CopyDataFromQueue(Queue *const queue, const void *buffer);
     }                                                   \
     TaskExitCritical();
 
+//
+// 統計情報の記録用マクロ.
+// CONFIG_USE_QUEUE_STATS が0のときは何もしない.
+//
+#if (CONFIG_USE_QUEUE_STATS == 1)
+    #define QueueStatsRecordPeak(queue)                                             \
+    do                                                                              \
+    {                                                                               \
+        if((queue)->messagesWaiting > (queue)->stats.peakMessagesWaiting)           \
+        {                                                                           \
+            (queue)->stats.peakMessagesWaiting = (queue)->messagesWaiting;          \
+        }                                                                           \
+    } while (0)
+
+    #define QueueStatsRecordFull(queue) (++((queue)->stats.fullCount))
+    #define QueueStatsRecordEmpty(queue) (++((queue)->stats.emptyCount))
+    #define QueueStatsRecordSendBlock(queue) (++((queue)->stats.sendBlockCount))
+    #define QueueStatsRecordReceiveBlock(queue) (++((queue)->stats.receiveBlockCount))
+
+    // Must be called after the blocked task has run again.
+    #define QueueStatsRecordBlockedTicks(queue, blockStart)                         \
+    do                                                                              \
+    {                                                                               \
+        TaskEnterCritical();                                                        \
+        {                                                                           \
+            (queue)->stats.blockedTicks += (TaskGetTickCount() - (blockStart));     \
+        }                                                                           \
+        TaskExitCritical();                                                         \
+    } while (0)
+#else
+    #define QueueStatsRecordPeak(queue)
+    #define QueueStatsRecordFull(queue)
+    #define QueueStatsRecordEmpty(queue)
+    #define QueueStatsRecordSendBlock(queue)
+    #define QueueStatsRecordReceiveBlock(queue)
+    #define QueueStatsRecordBlockedTicks(queue, blockStart)
+#endif
+
 PortBaseType QueueGenericReset(QueueHandle queueToReset, PortBaseType newQueue)
 {
     Queue *queue;
@@ -209,6 +343,15 @@ PortBaseType QueueGenericReset(QueueHandle queueToReset, PortBaseType newQueue)
         queue->rxLock = QUEUE_UNLOCKED;
         queue->txLock = QUEUE_UNLOCKED;
 
+        #if (CONFIG_USE_PRIORITY_QUEUES == 1)
+        {
+            if (queue->priorityIndex != NULL)
+            {
+                InitialisePriorityIndex(queue);
+            }
+        }
+        #endif
+
         if (newQueue == PD_FALSE)
         {
             // If there are tasks blocked waiting to read from the queue, then
@@ -246,6 +389,17 @@ QueueHandle QueueGenericCreate(unsigned PortBaseType queueLength, unsigned PortB
     // Remove compiler warnings about unused parameters.
     (void)queueType;
 
+    #if (CONFIG_USE_PRIORITY_QUEUES == 1)
+    {
+        // Slot numbers must leave room for PRIORITY_QUEUE_NO_SLOT.
+        // A length of 0 makes the creation below fail.
+        if ((queueType == QUEUE_QUEUE_TYPE_PRIORITY) && (queueLength >= PRIORITY_QUEUE_NO_SLOT))
+        {
+            queueLength = (unsigned PortBaseType)0U;
+        }
+    }
+    #endif
+
     // Allocate the new queue structure.
     if (queueLength > (unsigned PortBaseType)0)
     {
@@ -256,13 +410,43 @@ QueueHandle QueueGenericCreate(unsigned PortBaseType queueLength, unsigned PortB
             // longer than asked for to make wrap checking easier/faster.
             queueSizeInBytes = (size_t)(queueLength * itemSize) + (size_t)1;
 
+            #if (CONFIG_USE_PRIORITY_QUEUES == 1)
+            {
+                // The priority index is placed after the storage area.
+                if (queueType == QUEUE_QUEUE_TYPE_PRIORITY)
+                {
+                    queueSizeInBytes = PriorityIndexOffset(queueLength, itemSize);
+                    queueSizeInBytes += sizeof(PriorityIndex) + ((size_t)queueLength * sizeof(unsigned PortBaseType));
+                }
+            }
+            #endif
+
             newQueue->head = (signed char *)PortMalloc(queueSizeInBytes);
             if (newQueue->head != NULL)
             {
                 newQueue->length = queueLength;
                 newQueue->itemSize = itemSize;
+
+                #if (CONFIG_USE_PRIORITY_QUEUES == 1)
+                {
+                    if (queueType == QUEUE_QUEUE_TYPE_PRIORITY)
+                    {
+                        newQueue->priorityIndex = (PriorityIndex *)(newQueue->head + PriorityIndexOffset(queueLength, itemSize));
+                    }
+                    else
+                    {
+                        newQueue->priorityIndex = NULL;
+                    }
+                }
+                #endif
                 QueueGenericReset(newQueue, PD_TRUE);
 
+                #if (CONFIG_USE_QUEUE_STATS == 1)
+                {
+                    AddQueueToRegistry(newQueue);
+                }
+                #endif
+
                 TraceQueueCreate(newQueue);
                 ret = newQueue;
             }
@@ -306,10 +490,28 @@ QueueHandle QueueCreateMutex(unsigned char queueType)
         newQueue->rxLock = QUEUE_UNLOCKED;
         newQueue->txLock = QUEUE_UNLOCKED;
 
+        #if (CONFIG_USE_PRIORITY_QUEUES == 1)
+        {
+            newQueue->priorityIndex = NULL;
+        }
+        #endif
+
+        #if (CONFIG_USE_PRIORITY_CEILING_MUTEXES == 1)
+        {
+            newQueue->ceilingPriority = QUEUE_NO_CEILING;
+        }
+        #endif
+
         // Ensure the event queues start with the correct state.
         ListInitialise(&(newQueue->tasksWaitingToSend));
         ListInitialise(&(newQueue->tasksWaitingToReceive));
 
+        #if (CONFIG_USE_QUEUE_STATS == 1)
+        {
+            AddQueueToRegistry(newQueue);
+        }
+        #endif
+
         TraceCreateMutex(newQueue);
 
         // Start with the semaphore in the expected state.
@@ -324,12 +526,38 @@ QueueHandle QueueCreateMutex(unsigned char queueType)
 } 
 #endif
 
+#if (CONFIG_USE_PRIORITY_CEILING_MUTEXES == 1)
+QueueHandle QueueCreateCeilingMutex(unsigned PortBaseType ceilingPriority)
+{
+    Queue *newQueue;
+
+    newQueue = (Queue *)QueueCreateMutex(QUEUE_QUEUE_TYPE_CEILING_MUTEX);
+    if (newQueue != NULL)
+    {
+        // Set after the initial give so that it is not treated as a release.
+        if (ceilingPriority >= CONFIG_MAX_PRIORITIES)
+        {
+            ceilingPriority = CONFIG_MAX_PRIORITIES - (unsigned PortBaseType)1U;
+        }
+        newQueue->ceilingPriority = ceilingPriority;
+    }
+
+    return newQueue;
+}
+#endif
+
 signed PortBaseType QueueGenericSend(QueueHandle queueTo, const void * const itemToQueue, 
     PortTickType ticksToWait, PortBaseType copyPosition)
 {
     signed PortBaseType entryTimeSet = PD_FALSE;
     TimeOutType timeOut;
     Queue *queue;
+    #if (CONFIG_USE_QUEUE_STATS == 1)
+        PortTickType blockStart;
+    #endif
+    #if (CONFIG_USE_PRIORITY_CEILING_MUTEXES == 1)
+        signed PortBaseType restoreFromCeiling;
+    #endif
 
     queue = (Queue *)queueTo;
 
@@ -346,6 +574,23 @@ signed PortBaseType QueueGenericSend(QueueHandle queueTo, const void * const ite
             if (queue->messagesWaiting < queue->length)
             {
                 TraceQueueSend(queue);
+
+                #if (CONFIG_USE_PRIORITY_CEILING_MUTEXES == 1)
+                {
+                    // Giving back a held priority ceiling mutex. Only the holder was
+                    // raised to the ceiling, so only the holder restores its priority.
+                    if ((queue->isMutex == QUEUE_QUEUE_IS_MUTEX) && (QueueIsCeilingMutex(queue) != PD_FALSE) &&
+                        (queue->mutexHolder != NULL) && (queue->mutexHolder == TaskGetCurrentTaskHandle()))
+                    {
+                        restoreFromCeiling = PD_TRUE;
+                    }
+                    else
+                    {
+                        restoreFromCeiling = PD_FALSE;
+                    }
+                }
+                #endif
+
                 CopyDataToQueue(queue, itemToQueue, copyPosition);
 
                 // Queueからアイテムを取得しようと待機しているタスクを
@@ -364,6 +609,20 @@ signed PortBaseType QueueGenericSend(QueueHandle queueTo, const void * const ite
                     }
                 }
 
+                #if (CONFIG_USE_PRIORITY_CEILING_MUTEXES == 1)
+                {
+                    // Drop the ceiling only after the mutex is available, so a
+                    // task that preempts us here can take it.
+                    if (restoreFromCeiling != PD_FALSE)
+                    {
+                        if (TaskPriorityRestoreFromCeiling(queue->holderPriority) == PD_TRUE)
+                        {
+                            PortYieldWithinAPI();
+                        }
+                    }
+                }
+                #endif
+
                 TaskExitCritical();
 
                 // Return to the original privilage level before exiting the function.
@@ -375,6 +634,7 @@ signed PortBaseType QueueGenericSend(QueueHandle queueTo, const void * const ite
                 {
                     // The queue was full and no block time is specified
                     // (or the block time has expired) so leave now.
+                    QueueStatsRecordFull(queue);
                     TaskExitCritical();
 
                     // Return to the original privilage level before exiting
@@ -405,6 +665,12 @@ signed PortBaseType QueueGenericSend(QueueHandle queueTo, const void * const ite
             if (IsQueueFull(queue) != PD_FALSE)
             {
                 TraceBlockingOnQueueSend(queue);
+                QueueStatsRecordSendBlock(queue);
+                #if (CONFIG_USE_QUEUE_STATS == 1)
+                {
+                    blockStart = TaskGetTickCount();
+                }
+                #endif
                 TaskPlaceOnEventList(&(queue->tasksWaitingToSend), ticksToWait);
 
                 // Unlocking the queue means queue events can effect the
@@ -423,6 +689,9 @@ signed PortBaseType QueueGenericSend(QueueHandle queueTo, const void * const ite
                 {
                     PortYieldWithinAPI();
                 }
+
+                // We have been woken, either by the queue or by the timeout.
+                QueueStatsRecordBlockedTicks(queue, blockStart);
             }
             else
             {
@@ -439,6 +708,13 @@ signed PortBaseType QueueGenericSend(QueueHandle queueTo, const void * const ite
 
             // Return to the original privilage level before exiting the function.
             TraceQueueSendFailed(queue);
+            #if (CONFIG_USE_QUEUE_STATS == 1)
+            TaskEnterCritical();
+            {
+                QueueStatsRecordFull(queue);
+            }
+            TaskExitCritical();
+            #endif
             return ERR_QUEUE_FULL;
         }
     }
@@ -477,7 +753,7 @@ signed PortBaseType QueueGenericSendFromISR(QueueHandle queueTo, const void * co
                     // context switch is requred.
                     if (higherPriorityTaskWoken != NULL)
                     {
-                        higherPriorityTaskWoken = PD_TRUE;
+                        *higherPriorityTaskWoken = PD_TRUE;
                     }
                 }
             }
@@ -493,6 +769,7 @@ signed PortBaseType QueueGenericSendFromISR(QueueHandle queueTo, const void * co
     else
     {
         TraceQueueSendFromISRFailed(queue);
+        QueueStatsRecordFull(queue);
         ret = ERR_QUEUE_FULL;
     }
 
@@ -506,6 +783,9 @@ signed PortBaseType QueueGenericReceive(QueueHandle queueFrom, void * const buff
     TimeOutType timeOut;
     signed char *originalReadPositon;
     Queue *queue;
+    #if (CONFIG_USE_QUEUE_STATS == 1)
+        PortTickType blockStart;
+    #endif
 
     queue = (Queue *)queueFrom;
 
@@ -536,6 +816,15 @@ signed PortBaseType QueueGenericReceive(QueueHandle queueFrom, void * const buff
                     // We are actually removing data.
                     --(queue->messagesWaiting);
 
+                    #if (CONFIG_USE_PRIORITY_QUEUES == 1)
+                    {
+                        if (queue->priorityIndex != NULL)
+                        {
+                            RemoveHighestPriorityItem(queue);
+                        }
+                    }
+                    #endif
+
                     #if (CONFIG_USE_MUTEXES == 1)
                     {
                         if (queue->isMutex == QUEUE_QUEUE_IS_MUTEX)
@@ -543,6 +832,17 @@ signed PortBaseType QueueGenericReceive(QueueHandle queueFrom, void * const buff
                             // Record the information required to implement
                             // priority inheritance should it become necessary.
                             queue->mutexHolder = TaskGetCurrentTaskHandle();
+
+                            #if (CONFIG_USE_PRIORITY_CEILING_MUTEXES == 1)
+                            {
+                                // The holder runs at the ceiling until it gives the
+                                // mutex back, so no task that uses it can preempt it.
+                                if (queue->ceilingPriority != QUEUE_NO_CEILING)
+                                {
+                                    queue->holderPriority = TaskPriorityRaiseToCeiling(queue->ceilingPriority);
+                                }
+                            }
+                            #endif
                         }
                     }
                     #endif
@@ -590,6 +890,7 @@ signed PortBaseType QueueGenericReceive(QueueHandle queueFrom, void * const buff
                 {
                     // The queue was empty and no block time is specified (or
                     // the block time has expired) so leave now.
+                    QueueStatsRecordEmpty(queue);
                     TaskExitCritical();
                     TraceQueueReceiveFailed(queue);
                     return ERR_QUEUE_EMPTY;
@@ -621,10 +922,18 @@ signed PortBaseType QueueGenericReceive(QueueHandle queueFrom, void * const buff
             if (IsQueueEmpty(queue) != PD_FALSE)
             {
                 TraceBlockingOnQueueReceive(queue);
+                QueueStatsRecordReceiveBlock(queue);
+                #if (CONFIG_USE_QUEUE_STATS == 1)
+                {
+                    blockStart = TaskGetTickCount();
+                }
+                #endif
 
                 #if (CONFIG_USE_MUTEXES == 1)
                 {
-                    if (queue->isMutex == QUEUE_QUEUE_IS_MUTEX)
+                    // A priority ceiling mutex holder already runs at the ceiling,
+                    // so there is nothing to inherit.
+                    if ((queue->isMutex == QUEUE_QUEUE_IS_MUTEX) && (QueueIsCeilingMutex(queue) == PD_FALSE))
                     {
                         PortEnterCritical();
                         {
@@ -641,6 +950,9 @@ signed PortBaseType QueueGenericReceive(QueueHandle queueFrom, void * const buff
                 {
                     PortYieldWithinAPI();
                 }
+
+                // We have been woken, either by the queue or by the timeout.
+                QueueStatsRecordBlockedTicks(queue, blockStart);
             }
 
             // Queue内にデータがないとき
@@ -658,6 +970,13 @@ signed PortBaseType QueueGenericReceive(QueueHandle queueFrom, void * const buff
             UnlockQueue(queue);
             (void)TaskResumeAll();
             TraceQueueReceiveFailed(queue);
+            #if (CONFIG_USE_QUEUE_STATS == 1)
+            TaskEnterCritical();
+            {
+                QueueStatsRecordEmpty(queue);
+            }
+            TaskExitCritical();
+            #endif
             return ERR_QUEUE_EMPTY;
         }
     }
@@ -679,6 +998,15 @@ signed PortBaseType QueueReceiveFromISR(QueueHandle queueFrom, void * const buff
         CopyDataFromQueue(queue, buffer);
         --(queue->messagesWaiting);
 
+        #if (CONFIG_USE_PRIORITY_QUEUES == 1)
+        {
+            if (queue->priorityIndex != NULL)
+            {
+                RemoveHighestPriorityItem(queue);
+            }
+        }
+        #endif
+
         /* If the queue is locked we will not modify the event list.  Instead
         we update the lock count so the task that unlocks the queue will know
         that an ISR has removed data while the queue was locked. */
@@ -708,6 +1036,7 @@ signed PortBaseType QueueReceiveFromISR(QueueHandle queueFrom, void * const buff
     {
         ret = PD_FAIL;
         TraceQueueReceiveFromISRFailed(queue);
+        QueueStatsRecordEmpty(queue);
     }
 
     return ret;
@@ -743,6 +1072,12 @@ void QueueDelete(QueueHandle queueToDelete)
 
     TraceQueueDelete(queue);
 
+    #if (CONFIG_USE_QUEUE_STATS == 1)
+    {
+        RemoveQueueFromRegistry(queue);
+    }
+    #endif
+
     PortFree(queue->head);
     PortFree(queue);
 }
@@ -756,12 +1091,47 @@ static void CopyDataToQueue(Queue *queue, const void *itemToQueue, PortBaseType
             if (queue->isMutex == QUEUE_QUEUE_IS_MUTEX)
             {
                 // The mutex is no longer being held.
-                TaskPriorityDisinherit((void *)queue->mutexHolder);
+                // A priority ceiling mutex is restored by QueueGenericSend()
+                // once the mutex is available again.
+                if (QueueIsCeilingMutex(queue) == PD_FALSE)
+                {
+                    TaskPriorityDisinherit((void *)queue->mutexHolder);
+                }
                 queue->mutexHolder = NULL;
             }
         }
         #endif
     }
+    #if (CONFIG_USE_PRIORITY_QUEUES == 1)
+    else if (queue->priorityIndex != NULL)
+    {
+        PriorityIndex *index = queue->priorityIndex;
+        unsigned PortBaseType priority = (unsigned PortBaseType)position;
+        unsigned PortBaseType slot;
+
+        if (priority >= (unsigned PortBaseType)CONFIG_MAX_MESSAGE_PRIORITIES)
+        {
+            priority = (unsigned PortBaseType)CONFIG_MAX_MESSAGE_PRIORITIES - (unsigned PortBaseType)1U;
+        }
+
+        // Take a free slot and append it to the chain of its priority.
+        slot = index->freeSlot;
+        index->freeSlot = index->next[slot];
+        index->next[slot] = PRIORITY_QUEUE_NO_SLOT;
+
+        memcpy((void *)(queue->head + (slot * queue->itemSize)), itemToQueue, (unsigned)queue->itemSize);
+
+        if (index->first[priority] == PRIORITY_QUEUE_NO_SLOT)
+        {
+            index->first[priority] = slot;
+        }
+        else
+        {
+            index->next[index->last[priority]] = slot;
+        }
+        index->last[priority] = slot;
+    }
+    #endif
     else if (position == QUEUE_SEND_TO_BACK)
     {
         memcpy((void *)queue->writeTo, itemToQueue, (unsigned)queue->itemSize);
@@ -783,10 +1153,24 @@ static void CopyDataToQueue(Queue *queue, const void *itemToQueue, PortBaseType
     }
 
     ++(queue->messagesWaiting);
+    QueueStatsRecordPeak(queue);
 }
 
 static void CopyDataFromQueue(Queue * const queue, const void *buffer)
 {
+    #if (CONFIG_USE_PRIORITY_QUEUES == 1)
+    if (queue->priorityIndex != NULL)
+    {
+        unsigned PortBaseType priority;
+        unsigned PortBaseType slot;
+
+        // The item stays in its chain so a peek leaves the queue unchanged.
+        // RemoveHighestPriorityItem() unlinks it when it is really received.
+        slot = GetHighestPrioritySlot(queue, &priority);
+        memcpy((void *)buffer, (void *)(queue->head + (slot * queue->itemSize)), (unsigned)queue->itemSize);
+    }
+    else
+    #endif
     if (queue->isMutex != QUEUE_QUEUE_IS_MUTEX)
     {
         queue->readFrom += queue->itemSize;
@@ -911,4 +1295,147 @@ signed PortBaseType QueueIsQueueFullFromISR(const QueueHandle queue)
     }
 
     return ret;
-}
\ No newline at end of file
+}
+
+#if (CONFIG_USE_PRIORITY_QUEUES == 1)
+static void InitialisePriorityIndex(Queue *queue)
+{
+    PriorityIndex *index = queue->priorityIndex;
+    unsigned PortBaseType i;
+
+    for (i = (unsigned PortBaseType)0U; i < (unsigned PortBaseType)CONFIG_MAX_MESSAGE_PRIORITIES; i++)
+    {
+        index->first[i] = PRIORITY_QUEUE_NO_SLOT;
+        index->last[i] = PRIORITY_QUEUE_NO_SLOT;
+    }
+
+    // Chain all the slots onto the free list.
+    for (i = (unsigned PortBaseType)0U; i < queue->length; i++)
+    {
+        index->next[i] = i + (unsigned PortBaseType)1U;
+    }
+    index->next[queue->length - (unsigned PortBaseType)1U] = PRIORITY_QUEUE_NO_SLOT;
+    index->freeSlot = (unsigned PortBaseType)0U;
+}
+
+static unsigned PortBaseType GetHighestPrioritySlot(const Queue *queue, unsigned PortBaseType *priority)
+{
+    const PriorityIndex *index = queue->priorityIndex;
+    unsigned PortBaseType i = (unsigned PortBaseType)CONFIG_MAX_MESSAGE_PRIORITIES;
+
+    // 優先度の数だけ調べれば必ず見つかる. Queueが空でないことは呼び出し側で確認済み.
+    do
+    {
+        --i;
+    } while ((index->first[i] == PRIORITY_QUEUE_NO_SLOT) && (i > (unsigned PortBaseType)0U));
+
+    *priority = i;
+    return index->first[i];
+}
+
+static void RemoveHighestPriorityItem(Queue *queue)
+{
+    PriorityIndex *index = queue->priorityIndex;
+    unsigned PortBaseType priority;
+    unsigned PortBaseType slot;
+
+    slot = GetHighestPrioritySlot(queue, &priority);
+
+    // Unlink the slot from its priority chain and return it to the free chain.
+    index->first[priority] = index->next[slot];
+    if (index->first[priority] == PRIORITY_QUEUE_NO_SLOT)
+    {
+        index->last[priority] = PRIORITY_QUEUE_NO_SLOT;
+    }
+
+    index->next[slot] = index->freeSlot;
+    index->freeSlot = slot;
+}
+#endif
+
+#if (CONFIG_USE_QUEUE_STATS == 1)
+void QueueGetStats(const QueueHandle queue, QueueStats *stats)
+{
+    TaskEnterCritical();
+    {
+        *stats = ((Queue *)queue)->stats;
+    }
+    TaskExitCritical();
+}
+
+void QueueResetStats(QueueHandle queue)
+{
+    TaskEnterCritical();
+    {
+        memset((void *)&(((Queue *)queue)->stats), 0, sizeof(QueueStats));
+    }
+    TaskExitCritical();
+}
+
+QueueHandle QueueGetNextRegistered(const QueueHandle previous)
+{
+    QueueHandle ret;
+
+    TaskEnterCritical();
+    {
+        if (previous == NULL)
+        {
+            ret = queueRegistry;
+        }
+        else
+        {
+            ret = ((Queue *)previous)->nextRegistered;
+        }
+    }
+    TaskExitCritical();
+
+    return ret;
+}
+
+void QueueSetName(QueueHandle queue, const signed char *name)
+{
+    ((Queue *)queue)->name = name;
+}
+
+const signed char *QueueGetName(const QueueHandle queue)
+{
+    return ((Queue *)queue)->name;
+}
+
+unsigned PortBaseType QueueGetLength(const QueueHandle queue)
+{
+    return ((Queue *)queue)->length;
+}
+
+static void AddQueueToRegistry(Queue *queue)
+{
+    memset((void *)&(queue->stats), 0, sizeof(QueueStats));
+    queue->name = NULL;
+
+    // 新しいQueueはレジストリの先頭に追加する.
+    TaskEnterCritical();
+    {
+        queue->nextRegistered = queueRegistry;
+        queueRegistry = queue;
+    }
+    TaskExitCritical();
+}
+
+static void RemoveQueueFromRegistry(Queue *queue)
+{
+    Queue **link;
+
+    TaskEnterCritical();
+    {
+        for (link = &queueRegistry; *link != NULL; link = &((*link)->nextRegistered))
+        {
+            if (*link == queue)
+            {
+                *link = queue->nextRegistered;
+                break;
+            }
+        }
+    }
+    TaskExitCritical();
+}
+#endif
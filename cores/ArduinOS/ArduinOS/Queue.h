@@ -115,6 +115,8 @@ extern "C" {
 #define QUEUE_QUEUE_TYPE_COUNTING_SEMAPHORE (2U)
 #define QUEUE_QUEUE_TYPE_BINARY_SEMAPHORE (3U)
 #define QUEUE_QUEUE_TYPE_RECURSIVE_MUTEX (4U)
+#define QUEUE_QUEUE_TYPE_PRIORITY (5U)
+#define QUEUE_QUEUE_TYPE_CEILING_MUTEX (6U)
 
 
 /*
@@ -168,6 +170,81 @@ void Task(void *parameters)
 */
 #define QueueCreate(queueLength, itemSize) QueueGenericCreate(queueLength, itemSize, QUEUE_QUEUE_TYPE_BASE)
 
+#if (CONFIG_USE_PRIORITY_QUEUES == 1)
+/*
+// 優先度付きQueueを作成します.
+// 受信時は常に最も優先度の高いアイテムが取り出されます. 同じ優先度のアイテムは
+// 送信された順(FIFO)に取り出されます.
+//
+// 送信はQueueSendWithPriority()で行います. 送信, 受信にかかる時間は
+// Queueの長さに依存せず, 優先度の数(CONFIG_MAX_MESSAGE_PRIORITIES)のみに依存します.
+//
+// QueueSendToBack()で送信したアイテムは優先度0,
+// QueueSendToFront()で送信したアイテムは優先度1として扱われます.
+//
+// この関数はCONFIG_USE_PRIORITY_QUEUESが1のときのみ使用できます.
+//
+// @param queueLength:
+//  The maximum number of items that the queue can contain. Must be less than 255.
+//
+// @param itemSize:
+//  The number of bytes each item in the queue will require.
+//
+// @return:
+//  A handle to the newly created queue, or 0 if the queue cannot be created.
+//
+// Example usage :
+
+#define ALARM_PRIORITY 3
+#define TELEMETRY_PRIORITY 0
+
+QueueHandle commandQueue;
+
+void setup()
+{
+    commandQueue = QueuePriorityCreate(8, sizeof(struct Command));
+}
+
+TaskLoop(sensorTask)
+{
+    struct Command command;
+
+    // ...
+
+    // アラームは, Queue内に残っている通常の計測データより先に処理される.
+    if (alarm)
+    {
+        QueueSendWithPriority(commandQueue, &command, ALARM_PRIORITY, (PortTickType)10);
+    }
+    else
+    {
+        QueueSendWithPriority(commandQueue, &command, TELEMETRY_PRIORITY, (PortTickType)0);
+    }
+}
+*/
+#define QueuePriorityCreate(queueLength, itemSize) QueueGenericCreate(queueLength, itemSize, QUEUE_QUEUE_TYPE_PRIORITY)
+
+/*
+// 優先度付きQueueへアイテムを送信します.
+// このマクロはQueuePriorityCreate()で作成したQueueにのみ使用してください.
+//
+// @param priority:
+//  0 から CONFIG_MAX_MESSAGE_PRIORITIES - 1 までの優先度. 大きいほど先に受信されます.
+//  範囲外の値はCONFIG_MAX_MESSAGE_PRIORITIES - 1として扱われます.
+//
+// @return:
+//  PD_PASS if the item was successfully posted, otherwise ERR_QUEUE_FULL.
+*/
+#define QueueSendWithPriority(queue, itemToQueue, priority, ticksToWait) \
+    QueueGenericSend((queue), (itemToQueue), (ticksToWait), (PortBaseType)(priority))
+
+//
+// QueueSendWithPriority()の割り込み関数用です.
+//
+#define QueueSendWithPriorityFromISR(queue, itemToQueue, priority, higherPriorityTaskWoken) \
+    QueueGenericSendFromISR((queue), (itemToQueue), (higherPriorityTaskWoken), (PortBaseType)(priority))
+#endif
+
 /*
 // Queue先頭にアイテムを置きます. キューに置かれるアイテムは参照ではなくコピーです.
 // この関数は割り込み関数の中で呼ばないようにしてください.
@@ -1127,6 +1204,13 @@ void Task(void *parameters)
     */
     QueueHandle QueueCreateMutex(unsigned char queueType);
 
+#if (CONFIG_USE_PRIORITY_CEILING_MUTEXES == 1)
+    /*
+    // For internal use only.  Use SemaphoreCreateCeilingMutex() instead.
+    */
+    QueueHandle QueueCreateCeilingMutex(unsigned PortBaseType ceilingPriority);
+#endif
+
 
     /*
     // Reset a queue back to its original empty state.  PD_PASS is returned if the
@@ -1140,6 +1224,92 @@ void Task(void *parameters)
     // any queue, semaphore or mutex creation fuction or macro.
     QueueHandle QueueGenericCreate(unsigned PortBaseType queueLength, unsigned PortBaseType itemSize, unsigned char queueType);
 
+#if (CONFIG_USE_QUEUE_STATS == 1)
+
+    //
+    // Queueごとの統計情報
+    // CONFIG_USE_QUEUE_STATS が1のとき, 各Queue(Semaphore, Mutexを含む)に記録されます.
+    //
+    typedef struct
+    {
+        // The largest number of items ever held by the queue at once.
+        unsigned PortBaseType peakMessagesWaiting;
+
+        // The number of times a send returned ERR_QUEUE_FULL.
+        unsigned short fullCount;
+
+        // The number of times a receive returned ERR_QUEUE_EMPTY.
+        unsigned short emptyCount;
+
+        // The number of times a task blocked because the queue was full.
+        unsigned short sendBlockCount;
+
+        // The number of times a task blocked because the queue was empty.
+        unsigned short receiveBlockCount;
+
+        // The total number of ticks tasks have spent blocked on the queue.
+        unsigned long blockedTicks;
+    }QueueStats;
+
+    /*
+    // Queueの統計情報を取得します.
+    //
+    // @param queue:
+    //  The handle of the queue being queried.
+    //
+    // @param stats:
+    //  The structure into which the statistics are copied.
+    //
+    // Example usage:
+
+    TaskLoop(monitorTask)
+    {
+        QueueHandle queue = NULL;
+        QueueStats stats;
+
+        // 登録されているすべてのQueueの統計を出力する.
+        while ((queue = QueueGetNextRegistered(queue)) != NULL)
+        {
+            QueueGetStats(queue, &stats);
+            Serial.print((const char *)QueueGetName(queue));
+            Serial.print(' ');
+            Serial.print(stats.peakMessagesWaiting);
+            Serial.print('/');
+            Serial.println(QueueGetLength(queue));
+        }
+
+        TaskDelayMillis(10000);
+    }
+    */
+    void QueueGetStats(const QueueHandle queue, QueueStats *stats);
+
+    //
+    // Queueの統計情報を0に戻します.
+    //
+    void QueueResetStats(QueueHandle queue);
+
+    //
+    // レジストリに登録されたQueueを列挙します.
+    // NULLを渡すと最初のQueueを返します. 最後のQueueの次はNULLを返します.
+    //
+    // 列挙中にQueueが削除されないようにしてください.
+    //
+    QueueHandle QueueGetNextRegistered(const QueueHandle previous);
+
+    //
+    // Queueに名前を付けます. 統計情報を表示する際の識別に使用します.
+    // 名前の文字列はコピーされないので, Queueが存在する間は有効でなければなりません.
+    //
+    void QueueSetName(QueueHandle queue, const signed char *name);
+    const signed char *QueueGetName(const QueueHandle queue);
+
+    //
+    // Queueの長さ(格納できるアイテム数)を返します.
+    //
+    unsigned PortBaseType QueueGetLength(const QueueHandle queue);
+
+#endif
+
 
 
 #ifdef __cplusplus
@@ -202,9 +202,13 @@ void AnotherTask(void *parameters)
     }
 }
 */
-#define SemahoreTake(semaphore, blockTime) \
+#define SemaphoreTake(semaphore, blockTime) \
     QueueGenericReceive((QueueHandle)(semaphore), NULL, (blockTime), PD_FALSE)
 
+// 以前の綴り. 互換性のために残している.
+#define SemahoreTake(semaphore, blockTime) \
+    SemaphoreTake((semaphore), (blockTime))
+
 
 /*
 // Macro to release a semaphore.The semaphore must have previously been
@@ -425,6 +429,48 @@ void Task( void * parameters )
 */
 #define SemaphoreCreateMutex() QueueCreateMutex(QUEUE_QUEUE_TYPE_MUTEX)
 
+/**
+// 優先度上限プロトコル(immediate priority ceiling)を使用するMutexを作成します.
+//
+// Mutexを取得したタスクは, 取得した時点で直ちにceilingPriorityまで優先度が上がり,
+// Mutexを返すと取得前の優先度に戻ります. このMutexを使用するタスクの中で最も高い優先度を
+// ceilingPriorityに指定すると, 保持している間に他の使用タスクに割り込まれることがないため,
+// 競合による待機は起きず, 優先度継承のような競合時のリスト操作やコンテキストスイッチも不要です.
+// また, 複数のMutexをまたいだ連鎖的なブロックも防ぐことができます.
+//
+// Mutexは取得した順と逆の順で返してください.
+// ceilingPriorityより高い優先度のタスクが取得した場合, 優先度は変更されません.
+// 優先度継承を使用するMutex(SemaphoreCreateMutex())と同じタスクで入れ子にしないでください.
+//
+// CONFIG_USE_PRIORITY_CEILING_MUTEXES が1のときに使用できます.
+//
+// @param ceilingPriority:
+//  The priority the holder runs at. Clamped to CONFIG_MAX_PRIORITIES - 1.
+//
+// @return:
+//  Handle to the created mutex semaphore, or NULL if it could not be created.
+//
+// Example usage:
+
+SemaphoreHandle busMutex;
+
+void setup()
+{
+    // このMutexを使用するタスクの最高優先度は2.
+    busMutex = SemaphoreCreateCeilingMutex(2);
+}
+
+TaskLoop(sensorTask)
+{
+    if (SemaphoreTake(busMutex, PORT_MAX_DELAY) == PD_TRUE)
+    {
+        // ここでは優先度2で実行される.
+        SemaphoreGive(busMutex);
+    }
+}
+*/
+#define SemaphoreCreateCeilingMutex(ceilingPriority) QueueCreateCeilingMutex((unsigned PortBaseType)(ceilingPriority))
+
 /*
 //
 // Delete a semaphore. This function must be used with care. 
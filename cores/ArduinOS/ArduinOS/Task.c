@@ -196,6 +196,10 @@ static volatile unsigned PortBaseType schedulerSuspended = (unsigned PortBaseTyp
 static volatile unsigned PortBaseType missedTicks = (unsigned PortBaseType)0U;
 static volatile PortBaseType missedYield = (PortBaseType)PD_FALSE;
 static volatile PortBaseType numOfOverflows = (PortBaseType)0;
+
+// tickCountの桁あふれの回数. numOfOverflowsはタイムアウトの判定用で, PortBaseTypeのため
+// すぐに一周してしまう. TaskGetTickCount64()の上位に使用する.
+static volatile unsigned long tickCountHigh = 0UL;
 static unsigned PortBaseType taskNumber = (unsigned PortBaseType)0U;
 
 // 
@@ -430,6 +434,15 @@ signed PortBaseType TaskGenericCreate(TaskCode taskCode, const signed char *cons
         // the top of stack variable is updated.
         newTCB->topOfStack = PortInitialiseStack(topOfStack, taskCode, parameters);
 
+        // ポートがスタックを用意できなかったときはNULLが返る.
+        if (newTCB->topOfStack == NULL)
+        {
+            PortFreeAligned(newTCB->stack);
+            PortFree(newTCB);
+            TraceTaskCreateFailed();
+            return ERR_COULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+        }
+
         // 引数にハンドル変数があるとき.
         if ((void *)createdTask != NULL)
         {
@@ -903,7 +916,7 @@ void TaskStartScheduler(void)
     PortBaseType ret;
 
     // Add the idle task at the lowest priority
-    ret = TaskCreate(IdleTask, (signed char) "IDLE", IDLE_TASK_STACK_SIZE, (void *)NULL, IDLE_TASK_PRIORITY, NULL);
+    ret = TaskCreate(IdleTask, (const signed char *)"IDLE", IDLE_TASK_STACK_SIZE, (void *)NULL, IDLE_TASK_PRIORITY, NULL);
 
     /*
     #if (CONFIG_USE_TIMERS == 1)
@@ -1073,6 +1086,20 @@ PortTickType TaskGetTickCountFromISR(void)
     return ret;
 }
 
+unsigned long long TaskGetTickCount64(void)
+{
+    unsigned long long ticks;
+
+    TaskEnterCritical();
+    {
+        // PortTickTypeは16bitまたは32bit.
+        ticks = ((unsigned long long)tickCountHigh << ((PORT_MAX_DELAY == 0xffff) ? 16 : 32)) | tickCount;
+    }
+    TaskExitCritical();
+
+    return ticks;
+}
+
 unsigned PortBaseType TaskGetNumberOfTasks(void)
 {
     // A critical section is not required because the variables are of type
@@ -1100,6 +1127,7 @@ void TaskIncrementTick(void)
             delayedTaskList = overflowDelayedTaskList;
             overflowDelayedTaskList = temp;
             numOfOverflows++;
+            tickCountHigh++;
 
             // delayedListに変更があったため, これと連動しているnextTaskUnblockTime
             // も更新する必要がある.
@@ -1553,6 +1581,7 @@ static void DeleteTCB(TaskControlBlock *tcb)
     // タスクが保有するスタックを開放してから, TCBを開放する.
     // Free up the memory allocated by the scheduler for the task. It is up to
     // the task to free any memory allocated at the application level.
+    PortCleanUpTCB(tcb);
     PortFreeAligned(tcb->stack);
     PortFree(tcb);
 
@@ -1574,7 +1603,7 @@ TaskHandle TaskGetCurrentTaskHandle(void)
 }
 #endif
 
-#if ((INCLUDE_TASK_GET_SCHEDULER_STATE == 1) || (CONFIG_USE_MUTEXES == 1))
+// コアのライブラリ(taskCanBlock()など)が使用するため, 常にビルドする.
 PortBaseType TaskGetSchedulerState(void)
 {
     PortBaseType ret;
@@ -1597,7 +1626,6 @@ PortBaseType TaskGetSchedulerState(void)
 
     return ret;
 }
-#endif
 
 #if (CONFIG_USE_MUTEXES == 1)
 void TaskPriorityInherit(TaskHandle * const mutexHolder)
@@ -1664,4 +1692,67 @@ void TaskPriorityDisinherit(TaskHandle * const mutexHolder)
         }
     }
 }
-#endif
\ No newline at end of file
+#endif
+
+#if (CONFIG_USE_PRIORITY_CEILING_MUTEXES == 1)
+unsigned PortBaseType TaskPriorityRaiseToCeiling(unsigned PortBaseType ceilingPriority)
+{
+    unsigned PortBaseType previousPriority;
+
+    // Called by the running task when it takes the mutex, so it is in the ready state.
+    previousPriority = currentTCB->priority;
+
+    if (ceilingPriority >= CONFIG_MAX_PRIORITIES)
+    {
+        ceilingPriority = CONFIG_MAX_PRIORITIES - (unsigned PortBaseType)1U;
+    }
+
+    if (previousPriority < ceilingPriority)
+    {
+        if (ListRemove((ListItem *)&(currentTCB->genericListItem)) == 0)
+        {
+
+        }
+
+        TraceTaskPriorityInherit(currentTCB, ceilingPriority);
+        currentTCB->priority = ceilingPriority;
+        ListSetListItemValue(&(currentTCB->eventListItem), CONFIG_MAX_PRIORITIES - (PortTickType)ceilingPriority);
+        AddTaskToReadyQueue(currentTCB);
+    }
+
+    return previousPriority;
+}
+#endif
+
+#if (CONFIG_USE_PRIORITY_CEILING_MUTEXES == 1)
+signed PortBaseType TaskPriorityRestoreFromCeiling(unsigned PortBaseType previousPriority)
+{
+    unsigned PortBaseType priority;
+    signed PortBaseType ret = PD_FALSE;
+
+    if (currentTCB->priority != previousPriority)
+    {
+        if (ListRemove((ListItem *)&(currentTCB->genericListItem)) == 0)
+        {
+
+        }
+
+        TraceTaskPriorityDisinherit(currentTCB, previousPriority);
+        currentTCB->priority = previousPriority;
+        ListSetListItemValue(&(currentTCB->eventListItem), CONFIG_MAX_PRIORITIES - (PortTickType)previousPriority);
+        AddTaskToReadyQueue(currentTCB);
+
+        // 上限優先度で実行している間に, より優先度の高いタスクが準備状態になっているかもしれない.
+        for (priority = topReadyPriority; priority > previousPriority; --priority)
+        {
+            if (ListListIsEmpty(&(readyTasksLists[priority])) == PD_FALSE)
+            {
+                ret = PD_TRUE;
+                break;
+            }
+        }
+    }
+
+    return ret;
+}
+#endif
@@ -738,6 +738,16 @@ void OtherFunction(void)
     //
     PortTickType TaskGetTickCountFromISR(void);
 
+    //
+    // @return:
+    //  The count of ticks since TaskStartScheduler was called, extended to 64 bits.
+    //
+    // TaskGetTickCount()はCONFIG_USE_16_BIT_TICKSが1のとき, 1000Hzで約65秒で一周します.
+    // こちらは一周しないため, 長時間の経過時間の計測に使用できます.
+    // スケジューラが停止している間のtickは, TaskGetTickCount()と同じく再開したときに数えられます.
+    //
+    unsigned long long TaskGetTickCount64(void);
+
     /*
     // @return:
     //  The number of tasks that the real time kernel is currently managing.
@@ -877,6 +887,27 @@ void OtherFunction(void)
     //
     void TaskPriorityDisinherit(TaskHandle * const mutexHolder);
 
+    //
+    // 優先度上限プロトコル
+    // Mutexを取得した時点で, 実行中のタスクの優先度を直ちに上限優先度まで上げます.
+    // 競合が起きてから優先度を上げる優先度継承と異なり, 待機中のタスクのリスト操作は必要ありません.
+    //
+    // @return:
+    //  The priority of the calling task before it was raised. Pass it to
+    //  TaskPriorityRestoreFromCeiling() when the mutex is given back.
+    //
+    unsigned PortBaseType TaskPriorityRaiseToCeiling(unsigned PortBaseType ceilingPriority);
+
+    //
+    // Set the priority of the calling task back to the priority returned by
+    // TaskPriorityRaiseToCeiling().
+    //
+    // @return:
+    //  PD_TRUE if a task with a higher priority than the restored one is ready,
+    //  and a context switch should be performed.
+    //
+    signed PortBaseType TaskPriorityRestoreFromCeiling(unsigned PortBaseType previousPriority);
+
     /*
     // Generic versions of the task creation function which is in turn called by the
     // TaskCreate() macro.
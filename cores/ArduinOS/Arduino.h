@@ -141,8 +141,10 @@ void analogWrite(uint8_t, int);
 
 unsigned long millis(void);
 unsigned long micros(void);
+unsigned long long micros64(void);
 void delay(unsigned long);
 void delayMicroseconds(unsigned int us);
+void TaskDelayMicros(unsigned long us);
 unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout);
 unsigned long pulseInLong(uint8_t pin, uint8_t state, unsigned long timeout);
 
@@ -151,6 +153,7 @@ uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder);
 
 void attachInterrupt(uint8_t, void (*)(void), int mode);
 void detachInterrupt(uint8_t);
+void attachInterruptDeferred(uint8_t, void (*)(uint16_t edgeCount, unsigned long timestamp), int mode);
 
 void setup(void);
 void loop(void);
@@ -229,12 +232,17 @@ extern const uint8_t PROGMEM digital_pin_to_timer_PGM[];
 #endif
 
 #include "ArduinOS\ArduinOS.h"
+#include "TimerManager.h"
+#include "AdcService.h"
+#include "PinChangeInterrupt.h"
+#include "PulseService.h"
 
 #ifdef __cplusplus
 #include "WCharacter.h"
 #include "WString.h"
 #include "HardwareSerial.h"
 #include "USBAPI.h"
+#include "BufferedPrint.h"
 #if defined(HAVE_HWSERIAL0) && defined(HAVE_CDCSERIAL)
 #error "Targets with both UART0 and CDC serial not supported"
 #endif
@@ -0,0 +1,86 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+
+/*
+// バッファ付きPrint
+//
+// print()やprintf()が1文字ずつ呼ぶwrite(uint8_t)をバッファに溜め,
+// 出力先のwrite(const uint8_t *, size_t)にまとめて渡します.
+// 出力先が1byteごとに割り込み禁止やUSBの送信などを行う場合に, その回数を減らせます.
+//
+// バッファがいっぱいになったとき, flush()を呼んだとき, 破棄されるときに出力先へ書き込みます.
+// バッファはオブジェクトの中にあるため, タスクのスタックに置く場合はスタックサイズに注意してください.
+//
+// Example usage:
+
+TaskLoop(logTask)
+{
+    BufferedPrint<32> out(Serial);
+
+    out.print(F("adc="));
+    out.print(analogRead(A0));
+    out.println();
+    out.flush(); // 1回のSerial.write()で送信する.
+
+    TaskDelayMillis(100);
+}
+*/
+
+#ifndef BufferedPrint_h
+#define BufferedPrint_h
+
+#include <string.h>
+
+#include "Print.h"
+
+template <size_t N>
+class BufferedPrint : public Print
+{
+  private:
+    Print &_out;
+    size_t _length;
+    uint8_t _buffer[N];
+
+  public:
+    BufferedPrint(Print &out) : _out(out), _length(0) {}
+    ~BufferedPrint() { flush(); }
+
+    virtual size_t write(uint8_t c) {
+      if (_length == N) flush();
+      _buffer[_length++] = c;
+      return 1;
+    }
+
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+      // バッファより大きいものは, 溜めたものを出してから直接書き込む.
+      if (size >= N) {
+        flush();
+        return _out.write(buffer, size);
+      }
+      if (_length + size > N) flush();
+      memcpy(&_buffer[_length], buffer, size);
+      _length += size;
+      return size;
+    }
+    using Print::write;
+
+    // 溜めたものを出力先に書き込みます. 出力先のflush()は呼びません.
+    void flush() {
+      if (_length > 0) {
+        _out.write(_buffer, _length);
+        _length = 0;
+      }
+    }
+};
+
+#endif
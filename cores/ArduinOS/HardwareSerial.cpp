@@ -43,21 +43,33 @@
 #if defined(HAVE_HWSERIAL0)
   void serialEvent() __attribute__((weak));
   bool Serial0_available() __attribute__((weak));
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+  bool Serial0_eventTriggered() __attribute__((weak));
+#endif
 #endif
 
 #if defined(HAVE_HWSERIAL1)
   void serialEvent1() __attribute__((weak));
   bool Serial1_available() __attribute__((weak));
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+  bool Serial1_eventTriggered() __attribute__((weak));
+#endif
 #endif
 
 #if defined(HAVE_HWSERIAL2)
   void serialEvent2() __attribute__((weak));
   bool Serial2_available() __attribute__((weak));
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+  bool Serial2_eventTriggered() __attribute__((weak));
+#endif
 #endif
 
 #if defined(HAVE_HWSERIAL3)
   void serialEvent3() __attribute__((weak));
   bool Serial3_available() __attribute__((weak));
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+  bool Serial3_eventTriggered() __attribute__((weak));
+#endif
 #endif
 
 void serialEventRun(void)
@@ -76,6 +88,146 @@ void serialEventRun(void)
 #endif
 }
 
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+// 受信割り込みが条件を満たしたことを記録し, 待っているタスクを起こす.
+static volatile bool serialEventPending = false;
+static volatile bool serialEventWaiting = false;
+
+static SemaphoreHandle serialEventSemaphore = NULL;
+static TaskHandle serialEventTaskHandle = NULL;
+
+// serialEvent()が定義されているポートのどれかで, 未読のデータがまだ呼ぶ条件を満たしているか.
+static bool serialEventTriggered(void)
+{
+#if defined(HAVE_HWSERIAL0)
+  if (Serial0_eventTriggered && serialEvent && Serial0_eventTriggered()) return true;
+#endif
+#if defined(HAVE_HWSERIAL1)
+  if (Serial1_eventTriggered && serialEvent1 && Serial1_eventTriggered()) return true;
+#endif
+#if defined(HAVE_HWSERIAL2)
+  if (Serial2_eventTriggered && serialEvent2 && Serial2_eventTriggered()) return true;
+#endif
+#if defined(HAVE_HWSERIAL3)
+  if (Serial3_eventTriggered && serialEvent3 && Serial3_eventTriggered()) return true;
+#endif
+  return false;
+}
+
+static void SerialEventTask(void *parameters)
+{
+  bool pending;
+
+  (void)parameters;
+
+  for (;;) {
+    EnterCritical();
+    pending = serialEventPending;
+    serialEventPending = false;
+    // 受信割り込みに起こしてもらうため, 確認と同時に待っていることを知らせる.
+    serialEventWaiting = !pending;
+    ExitCritical();
+
+    if (!pending) {
+      SemaphoreTake(serialEventSemaphore, PORT_MAX_DELAY);
+      continue;
+    }
+
+    serialEventRun();
+
+    // serialEvent()の実行中に届いたデータは通知済みとして扱われることがあるため,
+    // 読み残したデータがまだ条件を満たしているときだけ, もう一度呼ぶ.
+    // (1フレーム分たまるまで読まないserialEvent()でも, ここで回り続けることはない.)
+    if (serialEventTriggered()) {
+      EnterCritical();
+      serialEventPending = true;
+      ExitCritical();
+    }
+  }
+}
+
+void serialEventNotifyFromISR(signed PortBaseType *higherPriorityTaskWoken)
+{
+  serialEventPending = true;
+
+  if (serialEventWaiting) {
+    serialEventWaiting = false;
+    SemaphoreGiveFromISR(serialEventSemaphore, higherPriorityTaskWoken);
+  }
+}
+#endif
+
+bool serialEventTaskStart(void)
+{
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+  bool used = false;
+
+  if (serialEventTaskHandle != NULL) {
+    return true;
+  }
+
+  // serialEvent()が1つも定義されていなければ, タスクもポーリングも必要ない.
+#if defined(HAVE_HWSERIAL0)
+  if (Serial0_available && serialEvent) used = true;
+#endif
+#if defined(HAVE_HWSERIAL1)
+  if (Serial1_available && serialEvent1) used = true;
+#endif
+#if defined(HAVE_HWSERIAL2)
+  if (Serial2_available && serialEvent2) used = true;
+#endif
+#if defined(HAVE_HWSERIAL3)
+  if (Serial3_available && serialEvent3) used = true;
+#endif
+  if (!used) {
+    return true;
+  }
+
+  // 作成に失敗したときは, 従来通りloop()の後で確認する.
+  if (serialEventSemaphore == NULL) {
+    SemaphoreCreateBinary(serialEventSemaphore);
+    if (serialEventSemaphore == NULL) {
+      return false;
+    }
+  }
+
+  // setup()の中で受信したものは, タスクが最初に確認する.
+  serialEventPending = true;
+
+  if (TaskCreate(SerialEventTask, (signed PortChar *)"SerialEvent", CONFIG_SERIAL_EVENT_STACK_SIZE,
+                 NULL, CONFIG_SERIAL_EVENT_PRIORITY, &serialEventTaskHandle) != PD_PASS) {
+    serialEventTaskHandle = NULL;
+    return false;
+  }
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+#if (CONFIG_USE_TASK_BLOCKING_SERIAL == 1)
+// タイムアウト(ms)をtick数にする. PORT_MILLIS_TO_TICKS()はPortTickTypeで計算し桁あふれするため,
+// unsigned longで計算し, PORT_MAX_DELAY(無期限)の手前で打ち切る.
+static PortTickType TimeoutToTicks(unsigned long ms)
+{
+  const unsigned long maxTicks = (unsigned long)(PORT_MAX_DELAY - 1);
+  unsigned long seconds = ms / 1000UL;
+  unsigned long ticks;
+  unsigned long remainder;
+
+  if (seconds > maxTicks / CONFIG_TICK_RATE_HZ) {
+    return PORT_MAX_DELAY - 1;
+  }
+  ticks = seconds * CONFIG_TICK_RATE_HZ;
+  remainder = (ms % 1000UL) * CONFIG_TICK_RATE_HZ / 1000UL;
+  if (ticks > maxTicks - remainder) {
+    return PORT_MAX_DELAY - 1;
+  }
+  return (PortTickType)(ticks + remainder);
+}
+#endif
+
 // Actual interrupt handlers //////////////////////////////////////////////////////////////
 
 void HardwareSerial::_tx_udr_empty_irq(void)
@@ -96,6 +248,19 @@ void HardwareSerial::_tx_udr_empty_irq(void)
     // Buffer empty, so disable interrupts
     cbi(*_ucsrb, UDRIE0);
   }
+
+#if (CONFIG_USE_TASK_BLOCKING_SERIAL == 1)
+  // 空きを待っているタスクは, バッファが半分空いてから起こす.
+  // 1byteごとにタスクを切り替えないようにするため.
+  if (_tx_waiting &&
+      (((unsigned int)(SERIAL_TX_BUFFER_SIZE + _tx_buffer_head - _tx_buffer_tail)) % SERIAL_TX_BUFFER_SIZE) <= (SERIAL_TX_BUFFER_SIZE / 2)) {
+    signed PortBaseType higherPriorityTaskWoken = PD_FALSE;
+
+    _tx_waiting = false;
+    SemaphoreGiveFromISR(_tx_semaphore, &higherPriorityTaskWoken);
+    YieldFromISR(higherPriorityTaskWoken);
+  }
+#endif
 }
 
 // Public Methods //////////////////////////////////////////////////////////////
@@ -123,6 +288,22 @@ void HardwareSerial::begin(unsigned long baud, byte config)
 
   _written = false;
 
+#if (CONFIG_USE_TASK_BLOCKING_SERIAL == 1)
+  // 作成に失敗したときは, 従来通り待ち続ける.
+  if (_rx_semaphore == NULL) {
+    SemaphoreCreateBinary(_rx_semaphore);
+  }
+  if (_tx_semaphore == NULL) {
+    SemaphoreCreateBinary(_tx_semaphore);
+  }
+#endif
+
+#if (CONFIG_USE_SERIAL_MUTEX == 1)
+  if (_tx_mutex == NULL) {
+    _tx_mutex = SemaphoreCreateMutex();
+  }
+#endif
+
   //set the data bits, parity, and stop bits
 #if defined(__AVR_ATmega8__)
   config |= 0x80; // select UCSRC register (shared with UBRRH)
@@ -212,6 +393,16 @@ void HardwareSerial::flush()
 
 size_t HardwareSerial::write(uint8_t c)
 {
+#if (CONFIG_USE_SERIAL_MUTEX == 1)
+  lock();
+  size_t n = writeUnlocked(c);
+  unlock();
+  return n;
+}
+
+size_t HardwareSerial::writeUnlocked(uint8_t c)
+{
+#endif
   _written = true;
   // If the buffer and the data register is empty, just write the byte
   // to the data register and be done. This shortcut helps
@@ -226,6 +417,68 @@ size_t HardwareSerial::write(uint8_t c)
 	
   // If the output buffer is full, there's nothing for it other than to 
   // wait for the interrupt handler to empty it a bit
+  waitForTxSpace(i);
+
+  _tx_buffer[_tx_buffer_head] = c;
+  _tx_buffer_head = i;
+	
+  sbi(*_ucsrb, UDRIE0);
+  
+  return 1;
+}
+
+// Copies a run of bytes into the free part of the output buffer and
+// publishes it with a single head update and UDRIE enable, instead of
+// going through write(uint8_t) once per byte.
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+
+  if (size == 0)
+    return 0;
+
+#if (CONFIG_USE_SERIAL_MUTEX == 1)
+  lock();
+#endif
+
+  _written = true;
+  // Same shortcut as write(uint8_t) for the first byte.
+  if (_tx_buffer_head == _tx_buffer_tail && bit_is_set(*_ucsra, UDRE0)) {
+    *_udr = buffer[n++];
+    sbi(*_ucsra, TXC0);
+  }
+
+  while (n < size) {
+    tx_buffer_index_t head = _tx_buffer_head;
+    tx_buffer_index_t next = (head + 1) % SERIAL_TX_BUFFER_SIZE;
+
+    waitForTxSpace(next);
+
+    // Only the interrupt handler moves the tail, and only forwards, so the
+    // space counted here can only grow while we copy.
+    size_t space = availableForWrite();
+    if (space > size - n) space = size - n;
+
+    while (space--) {
+      _tx_buffer[head] = buffer[n++];
+      head = (head + 1) % SERIAL_TX_BUFFER_SIZE;
+    }
+    _tx_buffer_head = head;
+
+    sbi(*_ucsrb, UDRIE0);
+  }
+
+#if (CONFIG_USE_SERIAL_MUTEX == 1)
+  unlock();
+#endif
+
+  return n;
+}
+
+// Waits until the byte before the tail is not i, i.e. writing at the
+// head and moving it to i would not overrun the interrupt handler.
+void HardwareSerial::waitForTxSpace(tx_buffer_index_t i)
+{
   while (i == _tx_buffer_tail) {
     if (bit_is_clear(SREG, SREG_I)) {
       // Interrupts are disabled, so we'll have to poll the data
@@ -234,17 +487,177 @@ size_t HardwareSerial::write(uint8_t c)
       // space for us.
       if(bit_is_set(*_ucsra, UDRE0))
 	_tx_udr_empty_irq();
-    } else {
+    }
+#if (CONFIG_USE_TASK_BLOCKING_SERIAL == 1)
+    else if (_tx_semaphore != NULL && taskCanBlock()) {
+      // 割り込みで空きができるまでタスクをブロックする.
+      // 割り込みに起こしてもらうため, 空きを確認する前に待っていることを知らせる.
+      _tx_waiting = true;
+      if (i == _tx_buffer_tail) {
+        SemaphoreTake(_tx_semaphore, TimeoutToTicks(_timeout));
+      }
+      _tx_waiting = false;
+    }
+#endif
+    else {
       // nop, the interrupt handler will free up space for us
     }
   }
+}
 
-  _tx_buffer[_tx_buffer_head] = c;
-  _tx_buffer_head = i;
-	
-  sbi(*_ucsrb, UDRIE0);
-  
-  return 1;
+bool HardwareSerial::lock(PortTickType ticksToWait)
+{
+#if (CONFIG_USE_SERIAL_MUTEX == 1)
+  if (_tx_mutex == NULL) {
+    return true;
+  }
+
+  // 所有者のタスクから(割り込み禁止中や, そのタスクに割り込んだ割り込み関数からも)
+  // 呼ばれたときは, 待機できるかに関係なく段数だけを増やす. unlock()は段数が0に
+  // なったときだけ返却するため, ミューテックスを実際に取得した呼び出しの対になる
+  // unlock()以外では返却されない.
+  TaskHandle self = TaskGetCurrentTaskHandle();
+  uint8_t oldSREG = SREG;
+  cli();
+  if (_tx_mutex_owner == self) {
+    _tx_mutex_depth++;
+    SREG = oldSREG;
+    return true;
+  }
+  SREG = oldSREG;
+
+  // 待機できないときは取得せずに書き込む. 対になるunlock()は所有者でないため何もしない.
+  if (!taskCanBlock()) {
+    return true;
+  }
+
+  if (SemaphoreTake(_tx_mutex, ticksToWait) != PD_TRUE) {
+    return false;
+  }
+  oldSREG = SREG;
+  cli();
+  _tx_mutex_owner = self;
+  _tx_mutex_depth = 1;
+  SREG = oldSREG;
+#else
+  (void)ticksToWait;
+#endif
+  return true;
 }
 
+void HardwareSerial::unlock(void)
+{
+#if (CONFIG_USE_SERIAL_MUTEX == 1)
+  bool release = false;
+
+  if (_tx_mutex == NULL) {
+    return;
+  }
+
+  uint8_t oldSREG = SREG;
+  cli();
+  if (_tx_mutex_owner != NULL && _tx_mutex_owner == TaskGetCurrentTaskHandle()) {
+    if (--_tx_mutex_depth == 0) {
+      _tx_mutex_owner = NULL;
+      release = true;
+    }
+  }
+  SREG = oldSREG;
+
+  // 段数が0になるのは取得したタスク自身のunlock()だけで, 割り込み関数から返却することはない.
+  if (release) {
+    SemaphoreGive(_tx_mutex);
+  }
+#endif
+}
+
+void HardwareSerial::setEventTrigger(rx_buffer_index_t threshold, int delimiter)
+{
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+  uint8_t oldSREG = SREG;
+  cli();
+  _event_threshold = (threshold == 0) ? 1 : threshold;
+  _event_delimiter = delimiter;
+  SREG = oldSREG;
+#else
+  (void)threshold;
+  (void)delimiter;
+#endif
+}
+
+bool HardwareSerial::eventTriggered(void)
+{
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+  rx_buffer_index_t head;
+  rx_buffer_index_t tail;
+  rx_buffer_index_t threshold;
+  int16_t delimiter;
+
+  uint8_t oldSREG = SREG;
+  cli();
+  head = _rx_buffer_head;
+  tail = _rx_buffer_tail;
+  threshold = _event_threshold;
+  delimiter = _event_delimiter;
+  SREG = oldSREG;
+
+  if (((unsigned int)(SERIAL_RX_BUFFER_SIZE + head - tail)) % SERIAL_RX_BUFFER_SIZE >= threshold) {
+    return true;
+  }
+  if (delimiter < 0) {
+    return false;
+  }
+  // バイト数が足りなくても, 区切り文字が残っていれば条件を満たしている.
+  while (tail != head) {
+    if (_rx_buffer[tail] == (unsigned char)delimiter) {
+      return true;
+    }
+    tail = (rx_buffer_index_t)(tail + 1) % SERIAL_RX_BUFFER_SIZE;
+  }
+  return false;
+#else
+  return false;
+#endif
+}
+
+#if (CONFIG_USE_TASK_BLOCKING_SERIAL == 1)
+int HardwareSerial::timedRead()
+{
+  return timedReceive(true);
+}
+
+int HardwareSerial::timedPeek()
+{
+  return timedReceive(false);
+}
+
+// 受信するまで, 最大_timeout(ms)の間タスクをブロックする.
+int HardwareSerial::timedReceive(bool consume)
+{
+  TimeOutType timeOut;
+  PortTickType ticksToWait;
+  int c;
+
+  if (_rx_semaphore == NULL || !taskCanBlock()) {
+    return consume ? Stream::timedRead() : Stream::timedPeek();
+  }
+
+  ticksToWait = TimeoutToTicks(_timeout);
+  TaskSetTimeOutState(&timeOut);
+
+  for (;;) {
+    // 受信割り込みに起こしてもらうため, 受信を確認する前に待っていることを知らせる.
+    _rx_waiting = true;
+    c = consume ? read() : peek();
+    if (c >= 0 || TaskCheckForTimeOut(&timeOut, &ticksToWait) != PD_FALSE) {
+      break;
+    }
+    SemaphoreTake(_rx_semaphore, ticksToWait);
+  }
+  _rx_waiting = false;
+
+  return c;
+}
+#endif
+
 #endif // whole file
@@ -107,6 +107,39 @@ class HardwareSerial : public Stream
     volatile tx_buffer_index_t _tx_buffer_head;
     volatile tx_buffer_index_t _tx_buffer_tail;
 
+#if (CONFIG_USE_TASK_BLOCKING_SERIAL == 1)
+    // 受信待ち, 送信バッファの空き待ちでブロックしているタスクを割り込みから起こすためのセマフォ.
+    // begin()で作成される.
+    SemaphoreHandle _rx_semaphore;
+    SemaphoreHandle _tx_semaphore;
+
+    // タスクが待っているときだけ, 割り込みでセマフォを与える.
+    volatile bool _rx_waiting;
+    volatile bool _tx_waiting;
+
+    virtual int timedRead();
+    virtual int timedPeek();
+    int timedReceive(bool consume);
+#endif
+
+    void waitForTxSpace(tx_buffer_index_t);
+
+#if (CONFIG_USE_SERIAL_MUTEX == 1)
+    // 送信を排他するMutex. begin()で作成される.
+    // 同じタスクが入れ子で取得できるよう, 所有者と回数を記録する.
+    SemaphoreHandle _tx_mutex;
+    TaskHandle _tx_mutex_owner;
+    uint8_t _tx_mutex_depth;
+
+    size_t writeUnlocked(uint8_t);
+#endif
+
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+    // serialEvent()を呼ぶタスクを起こす条件. setEventTrigger()で設定される.
+    rx_buffer_index_t _event_threshold;
+    int16_t _event_delimiter;
+#endif
+
     // Don't put any members after these buffers, since only the first
     // 32 bytes of this struct can be accessed quickly using the ldd
     // instruction.
@@ -127,6 +160,7 @@ class HardwareSerial : public Stream
     int availableForWrite(void);
     virtual void flush(void);
     virtual size_t write(uint8_t);
+    virtual size_t write(const uint8_t *, size_t);
     inline size_t write(unsigned long n) { return write((uint8_t)n); }
     inline size_t write(long n) { return write((uint8_t)n); }
     inline size_t write(unsigned int n) { return write((uint8_t)n); }
@@ -134,6 +168,26 @@ class HardwareSerial : public Stream
     using Print::write; // pull in write(str) and write(buf, size) from Print
     operator bool() { return true; }
 
+    // CONFIG_USE_SERIAL_MUTEX が1のとき, 送信を他のタスクから排他します.
+    // 同じタスクの中では入れ子にできます. lock()とunlock()は同じ回数呼んでください.
+    // 割り込み関数の中, スケジューラが動作していないときは何もしません.
+    // CONFIG_USE_SERIAL_MUTEX が0のときも呼べます(何もしません).
+    bool lock(PortTickType ticksToWait = PORT_MAX_DELAY);
+    void unlock(void);
+
+    // CONFIG_USE_SERIAL_EVENT_TASK が1のとき, serialEvent()を呼ぶ条件を設定します.
+    // 受信したバイト数がthreshold以上になったとき, またはdelimiterを受信したときに呼ばれます.
+    // delimiterが-1のときはバイト数だけで判断します. 初期値はthreshold 1(受信するたび).
+    // CONFIG_USE_SERIAL_EVENT_TASK が0のときも呼べます(何もしません).
+    //
+    // Example usage:
+    //  Serial.setEventTrigger(SERIAL_RX_BUFFER_SIZE / 2, '\n'); // 1行か, バッファの半分
+    void setEventTrigger(rx_buffer_index_t threshold, int delimiter = -1);
+
+    // 未読のデータがsetEventTrigger()の条件を満たしているかを返します.
+    // serialEvent()がデータを読み残したとき, もう一度呼ぶかの判断に使われます.
+    bool eventTriggered(void);
+
     // Interrupt handlers - Not intended to be called externally
     inline void _rx_complete_irq(void);
     void _tx_udr_empty_irq(void);
@@ -156,6 +210,39 @@ class HardwareSerial : public Stream
   #define HAVE_HWSERIAL3
 #endif
 
+/*
+// スコープの間, シリアルポートの送信を排他します.
+// 複数のprint()を他のタスクの出力と混ざらない1行として送信できます.
+//
+// Example usage:
+
+TaskLoop(sensorTask)
+{
+    {
+        SerialLock lock(Serial);
+
+        Serial.print(F("temp="));
+        Serial.print(readTemperature());
+        Serial.println(F(" C"));
+    } // ここで解放される.
+
+    TaskDelayMillis(500);
+}
+*/
+class SerialLock
+{
+  private:
+    HardwareSerial &_port;
+
+  public:
+    SerialLock(HardwareSerial &port) : _port(port) { _port.lock(); }
+    ~SerialLock() { _port.unlock(); }
+};
+
 extern void serialEventRun(void) __attribute__((weak));
 
+// CONFIG_USE_SERIAL_EVENT_TASK が1のとき, serialEvent()を呼ぶタスクを作成します. main.cppから呼ばれる.
+// serialEventRun()をloop()の後で呼ぶ必要がなくなったときtrueを返します.
+extern bool serialEventTaskStart(void) __attribute__((weak));
+
 #endif
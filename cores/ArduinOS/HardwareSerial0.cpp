@@ -37,11 +37,11 @@
 #if defined(HAVE_HWSERIAL0)
 
 #if defined(USART_RX_vect)
-  ISR(USART_RX_vect)
+  ISR_WAKING_TASK(USART_RX_vect)
 #elif defined(USART0_RX_vect)
-  ISR(USART0_RX_vect)
+  ISR_WAKING_TASK(USART0_RX_vect)
 #elif defined(USART_RXC_vect)
-  ISR(USART_RXC_vect) // ATmega8
+  ISR_WAKING_TASK(USART_RXC_vect) // ATmega8
 #else
   #error "Don't know what the Data Received vector is called for Serial"
 #endif
@@ -50,13 +50,13 @@
   }
 
 #if defined(UART0_UDRE_vect)
-ISR(UART0_UDRE_vect)
+ISR_WAKING_TASK(UART0_UDRE_vect)
 #elif defined(UART_UDRE_vect)
-ISR(UART_UDRE_vect)
+ISR_WAKING_TASK(UART_UDRE_vect)
 #elif defined(USART0_UDRE_vect)
-ISR(USART0_UDRE_vect)
+ISR_WAKING_TASK(USART0_UDRE_vect)
 #elif defined(USART_UDRE_vect)
-ISR(USART_UDRE_vect)
+ISR_WAKING_TASK(USART_UDRE_vect)
 #else
   #error "Don't know what the Data Register Empty vector is called for Serial"
 #endif
@@ -76,4 +76,10 @@ bool Serial0_available() {
   return Serial.available();
 }
 
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+bool Serial0_eventTriggered() {
+  return Serial.eventTriggered();
+}
+#endif
+
 #endif // HAVE_HWSERIAL0
@@ -37,9 +37,9 @@
 #if defined(HAVE_HWSERIAL1)
 
 #if defined(UART1_RX_vect)
-ISR(UART1_RX_vect)
+ISR_WAKING_TASK(UART1_RX_vect)
 #elif defined(USART1_RX_vect)
-ISR(USART1_RX_vect)
+ISR_WAKING_TASK(USART1_RX_vect)
 #else
 #error "Don't know what the Data Register Empty vector is called for Serial1"
 #endif
@@ -48,9 +48,9 @@ ISR(USART1_RX_vect)
 }
 
 #if defined(UART1_UDRE_vect)
-ISR(UART1_UDRE_vect)
+ISR_WAKING_TASK(UART1_UDRE_vect)
 #elif defined(USART1_UDRE_vect)
-ISR(USART1_UDRE_vect)
+ISR_WAKING_TASK(USART1_UDRE_vect)
 #else
 #error "Don't know what the Data Register Empty vector is called for Serial1"
 #endif
@@ -66,4 +66,10 @@ bool Serial1_available() {
   return Serial1.available();
 }
 
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+bool Serial1_eventTriggered() {
+  return Serial1.eventTriggered();
+}
+#endif
+
 #endif // HAVE_HWSERIAL1
@@ -36,12 +36,12 @@
 
 #if defined(HAVE_HWSERIAL2)
 
-ISR(USART2_RX_vect)
+ISR_WAKING_TASK(USART2_RX_vect)
 {
   Serial2._rx_complete_irq();
 }
 
-ISR(USART2_UDRE_vect)
+ISR_WAKING_TASK(USART2_UDRE_vect)
 {
   Serial2._tx_udr_empty_irq();
 }
@@ -54,4 +54,10 @@ bool Serial2_available() {
   return Serial2.available();
 }
 
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+bool Serial2_eventTriggered() {
+  return Serial2.eventTriggered();
+}
+#endif
+
 #endif // HAVE_HWSERIAL2
@@ -36,12 +36,12 @@
 
 #if defined(HAVE_HWSERIAL3)
 
-ISR(USART3_RX_vect)
+ISR_WAKING_TASK(USART3_RX_vect)
 {
   Serial3._rx_complete_irq();
 }
 
-ISR(USART3_UDRE_vect)
+ISR_WAKING_TASK(USART3_UDRE_vect)
 {
   Serial3._tx_udr_empty_irq();
 }
@@ -54,4 +54,10 @@ bool Serial3_available() {
   return Serial3.available();
 }
 
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+bool Serial3_eventTriggered() {
+  return Serial3.eventTriggered();
+}
+#endif
+
 #endif // HAVE_HWSERIAL3
@@ -82,6 +82,11 @@
 #error "Not all bit positions for UART3 are the same as for UART0"
 #endif
 
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+// HardwareSerial.cpp. 受信割り込みから呼ばれ, serialEvent()を呼ぶタスクを起こす.
+void serialEventNotifyFromISR(signed PortBaseType *higherPriorityTaskWoken);
+#endif
+
 // Constructors ////////////////////////////////////////////////////////////////
 
 HardwareSerial::HardwareSerial(
@@ -93,6 +98,16 @@ HardwareSerial::HardwareSerial(
     _udr(udr),
     _rx_buffer_head(0), _rx_buffer_tail(0),
     _tx_buffer_head(0), _tx_buffer_tail(0)
+#if (CONFIG_USE_TASK_BLOCKING_SERIAL == 1)
+    , _rx_semaphore(NULL), _tx_semaphore(NULL),
+    _rx_waiting(false), _tx_waiting(false)
+#endif
+#if (CONFIG_USE_SERIAL_MUTEX == 1)
+    , _tx_mutex(NULL), _tx_mutex_owner(NULL), _tx_mutex_depth(0)
+#endif
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+    , _event_threshold(1), _event_delimiter(-1)
+#endif
 {
 }
 
@@ -113,6 +128,30 @@ void HardwareSerial::_rx_complete_irq(void)
     if (i != _rx_buffer_tail) {
       _rx_buffer[_rx_buffer_head] = c;
       _rx_buffer_head = i;
+
+#if (CONFIG_USE_TASK_BLOCKING_SERIAL == 1) || (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+      signed PortBaseType higherPriorityTaskWoken = PD_FALSE;
+#endif
+
+#if (CONFIG_USE_TASK_BLOCKING_SERIAL == 1)
+      // 受信を待っているタスクを起こす.
+      if (_rx_waiting) {
+        _rx_waiting = false;
+        SemaphoreGiveFromISR(_rx_semaphore, &higherPriorityTaskWoken);
+      }
+#endif
+
+#if (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+      // serialEvent()を呼ぶタスクを起こす.
+      if ((c == _event_delimiter) ||
+          (((unsigned int)(SERIAL_RX_BUFFER_SIZE + i - _rx_buffer_tail)) % SERIAL_RX_BUFFER_SIZE) >= _event_threshold) {
+        serialEventNotifyFromISR(&higherPriorityTaskWoken);
+      }
+#endif
+
+#if (CONFIG_USE_TASK_BLOCKING_SERIAL == 1) || (CONFIG_USE_SERIAL_EVENT_TASK == 1)
+      YieldFromISR(higherPriorityTaskWoken);
+#endif
     }
   } else {
     // Parity error, read byte but discard it
@@ -0,0 +1,202 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+#include "wiring_private.h"
+#include "pins_arduino.h"
+#include "PinChangeInterrupt.h"
+
+#if (CONFIG_USE_PIN_CHANGE_INTERRUPTS == 1) && defined(PCICR)
+
+typedef struct
+{
+    // どちらもNULLのとき, 使用されていない.
+    PinChangeCallback callback;
+    QueueHandle queue;
+
+    volatile uint8_t *inputRegister;
+    uint8_t bitMask;
+    uint8_t pin;
+    uint8_t mode;
+
+    // PCICRのビット番号
+    uint8_t bank;
+
+    // 前回の割り込みでのピンの状態
+    uint8_t lastState;
+} PinChangeEntry;
+
+static PinChangeEntry entries[CONFIG_PIN_CHANGE_MAX_PINS];
+
+//
+// 割り込み関数から呼ばれる. ポートに登録されたピンのうち, 変化したものを知らせます.
+//
+static void DispatchPinChange(uint8_t bank)
+{
+    signed PortBaseType higherPriorityTaskWoken = PD_FALSE;
+    PinChangeEntry *entry;
+    PinChangeEvent event;
+    uint8_t state;
+
+    for (entry = entries; entry < &entries[CONFIG_PIN_CHANGE_MAX_PINS]; entry++)
+    {
+        if (((entry->callback == NULL) && (entry->queue == NULL)) || (entry->bank != bank))
+        {
+            continue;
+        }
+
+        state = (*entry->inputRegister & entry->bitMask) ? HIGH : LOW;
+        if (state == entry->lastState)
+        {
+            continue;
+        }
+        entry->lastState = state;
+
+        if (((entry->mode == RISING) && (state == LOW)) || ((entry->mode == FALLING) && (state == HIGH)))
+        {
+            continue;
+        }
+
+        if (entry->callback != NULL)
+        {
+            entry->callback(entry->pin, state, &higherPriorityTaskWoken);
+        }
+        else
+        {
+            event.pin = entry->pin;
+            event.state = state;
+            QueueSendFromISR(entry->queue, &event, &higherPriorityTaskWoken);
+        }
+    }
+
+    YieldFromISR(higherPriorityTaskWoken);
+}
+
+#if defined(PCINT0_vect)
+ISR_WAKING_TASK(PCINT0_vect)
+{
+    DispatchPinChange(0);
+}
+#endif
+
+#if defined(PCINT1_vect)
+ISR_WAKING_TASK(PCINT1_vect)
+{
+    DispatchPinChange(1);
+}
+#endif
+
+#if defined(PCINT2_vect)
+ISR_WAKING_TASK(PCINT2_vect)
+{
+    DispatchPinChange(2);
+}
+#endif
+
+#if defined(PCINT3_vect)
+ISR_WAKING_TASK(PCINT3_vect)
+{
+    DispatchPinChange(3);
+}
+#endif
+
+static PinChangeEntry *FindEntry(uint8_t pin)
+{
+    PinChangeEntry *entry;
+
+    for (entry = entries; entry < &entries[CONFIG_PIN_CHANGE_MAX_PINS]; entry++)
+    {
+        if (((entry->callback != NULL) || (entry->queue != NULL)) && (entry->pin == pin))
+        {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static signed PortBaseType Attach(uint8_t pin, PinChangeCallback callback, QueueHandle queue, int mode)
+{
+    PinChangeEntry *entry;
+    uint8_t port = digitalPinToPort(pin);
+
+    if ((port == NOT_A_PIN) || (digitalPinToPCICR(pin) == NULL) ||
+        ((mode != CHANGE) && (mode != RISING) && (mode != FALLING)) || (FindEntry(pin) != NULL))
+    {
+        return PD_FAIL;
+    }
+
+    for (entry = entries; entry < &entries[CONFIG_PIN_CHANGE_MAX_PINS]; entry++)
+    {
+        if ((entry->callback == NULL) && (entry->queue == NULL))
+        {
+            break;
+        }
+    }
+
+    if (entry == &entries[CONFIG_PIN_CHANGE_MAX_PINS])
+    {
+        return PD_FAIL;
+    }
+
+    EnterCritical();
+    {
+        entry->inputRegister = portInputRegister(port);
+        entry->bitMask = digitalPinToBitMask(pin);
+        entry->pin = pin;
+        entry->mode = mode;
+        entry->bank = digitalPinToPCICRbit(pin);
+        entry->lastState = (*entry->inputRegister & entry->bitMask) ? HIGH : LOW;
+        entry->callback = callback;
+        entry->queue = queue;
+
+        *digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+        *digitalPinToPCICR(pin) |= _BV(entry->bank);
+    }
+    ExitCritical();
+
+    return PD_PASS;
+}
+
+signed PortBaseType PinChangeAttach(uint8_t pin, PinChangeCallback callback, int mode)
+{
+    return (callback == NULL) ? PD_FAIL : Attach(pin, callback, NULL, mode);
+}
+
+signed PortBaseType PinChangeAttachQueue(uint8_t pin, QueueHandle queue, int mode)
+{
+    return (queue == NULL) ? PD_FAIL : Attach(pin, NULL, queue, mode);
+}
+
+void PinChangeDetach(uint8_t pin)
+{
+    PinChangeEntry *entry = FindEntry(pin);
+
+    if (entry == NULL)
+    {
+        return;
+    }
+
+    EnterCritical();
+    {
+        *digitalPinToPCMSK(pin) &= ~_BV(digitalPinToPCMSKbit(pin));
+        if (*digitalPinToPCMSK(pin) == 0)
+        {
+            *digitalPinToPCICR(pin) &= ~_BV(entry->bank);
+        }
+
+        entry->callback = NULL;
+        entry->queue = NULL;
+    }
+    ExitCritical();
+}
+
+#endif
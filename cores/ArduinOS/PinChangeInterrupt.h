@@ -0,0 +1,127 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+
+/*
+// ピン変化割り込み
+//
+// CONFIG_USE_PIN_CHANGE_INTERRUPTS が1のとき, ピン変化割り込み(PCINT)をピンごとに使用できます.
+// attachInterrupt()で使用できる外部割り込みのピン(UNOでは2, 3番)以外のピンでも, 変化を割り込みで受け取れます.
+//
+// ピン変化割り込みはポート(PCINT0, PCINT1, ...)ごとに1つの割り込み関数です.
+// 割り込み関数では, 登録されたピンの状態を前回の状態と比べ, 変化したピンごとに
+// 登録された関数を呼ぶか, キューに PinChangeEvent を送ります.
+//
+// PCINTn_vectを定義するため, SoftwareSerialなど, ピン変化割り込みを使用するライブラリとは同時に使用できません.
+// パルス測定サービス(PulseService.h)は, ICP1以外のピンの測定にピン変化割り込みを使用します.
+*/
+
+#ifndef PIN_CHANGE_INTERRUPT_H
+#define PIN_CHANGE_INTERRUPT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (CONFIG_USE_PIN_CHANGE_INTERRUPTS == 1)
+
+    //
+    // PinChangeAttachQueue()で登録したキューに送られる要素.
+    //
+    typedef struct
+    {
+        uint8_t pin;
+
+        // 変化した後のピンの状態(HIGH, LOW)
+        uint8_t state;
+    } PinChangeEvent;
+
+    //
+    // ピンが変化したときに割り込み関数の中で呼ばれる関数.
+    // ...FromISR()関数を使用した場合は, higherPriorityTaskWokenを渡してください.
+    // 割り込み関数の終わりでYieldFromISR()が呼ばれます.
+    //
+    typedef void (*PinChangeCallback)(uint8_t pin, uint8_t state, signed PortBaseType *higherPriorityTaskWoken);
+
+    /*
+    // ピンが変化したときに呼ぶ関数を登録します.
+    // ピンのモード(INPUT, INPUT_PULLUP)は呼び出し側で設定してください.
+    //
+    // @param pin:
+    //  ピン変化割り込みを使用できるピン.
+    //
+    // @param callback:
+    //  割り込み関数の中で呼ばれる関数.
+    //
+    // @param mode:
+    //  CHANGE, RISING, FALLING のいずれか.
+    //
+    // @return:
+    //  PD_PASS if the pin was attached, otherwise PD_FAIL.
+    */
+    signed PortBaseType PinChangeAttach(uint8_t pin, PinChangeCallback callback, int mode);
+
+    /*
+    // ピンが変化したときに PinChangeEvent を送るキューを登録します.
+    // 複数のピンに同じキューを登録できます. キューがいっぱいのときは捨てられます.
+    //
+    // @param queue:
+    //  要素のサイズがsizeof(PinChangeEvent)のキュー.
+    //
+    // @return:
+    //  PD_PASS if the pin was attached, otherwise PD_FAIL.
+    //
+    // Example usage:
+
+    const uint8_t buttons[] = {4, 5, 6, 7, 8, 9};
+    QueueHandle buttonQueue;
+
+    TaskLoop(buttonTask)
+    {
+        PinChangeEvent event;
+
+        // ボタンが押されるまでブロックする.
+        if (QueueReceive(buttonQueue, &event, PORT_MAX_DELAY) == PD_PASS)
+        {
+            Serial.println(event.pin);
+        }
+    }
+
+    void setup()
+    {
+        buttonQueue = QueueCreate(8, sizeof(PinChangeEvent));
+
+        for (uint8_t i = 0; i < sizeof(buttons); i++)
+        {
+            pinMode(buttons[i], INPUT_PULLUP);
+            PinChangeAttachQueue(buttons[i], buttonQueue, FALLING);
+        }
+        CreateTaskLoop(buttonTask, NORMAL_PRIORITY);
+    }
+    */
+    signed PortBaseType PinChangeAttachQueue(uint8_t pin, QueueHandle queue, int mode);
+
+    /*
+    // ピンの登録を解除します.
+    // ポートに登録されたピンがなくなると, そのポートのピン変化割り込みを禁止します.
+    */
+    void PinChangeDetach(uint8_t pin);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
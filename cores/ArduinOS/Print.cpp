@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdarg.h>
 #include <math.h>
 #include "Arduino.h"
 
@@ -198,8 +199,99 @@ size_t Print::println(const Printable& x)
   return n;
 }
 
+size_t Print::printf(const char *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  size_t n = printFormatted(format, false, args);
+  va_end(args);
+  return n;
+}
+
+size_t Print::printf(const __FlashStringHelper *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  size_t n = printFormatted(reinterpret_cast<const char *>(format), true, args);
+  va_end(args);
+  return n;
+}
+
+size_t Print::printf_P(PGM_P format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  size_t n = printFormatted(format, true, args);
+  va_end(args);
+  return n;
+}
+
+size_t Print::vprintf(const char *format, va_list args)
+{
+  return printFormatted(format, false, args);
+}
+
+size_t Print::vprintf_P(PGM_P format, va_list args)
+{
+  return printFormatted(format, true, args);
+}
+
 // Private Methods /////////////////////////////////////////////////////////////
 
+// AVR has no divide instruction, so n / 10 is computed with shifts and adds
+// (Hacker's Delight, divu10). The quotient may be one too small; the
+// remainder check corrects it. Narrower types are used as soon as the value
+// fits, since every shift costs one instruction per byte.
+static char *formatDecimal(unsigned long n, char *str, uint8_t minDigits)
+{
+  while (n > 0xFFFF) {
+    unsigned long q = (n >> 1) + (n >> 2);
+    q += q >> 4;
+    q += q >> 8;
+    q += q >> 16;
+    q >>= 3;
+    uint8_t r = (uint8_t)(n - ((q << 3) + (q << 1)));
+    if (r > 9) {
+      q++;
+      r -= 10;
+    }
+    *--str = '0' + r;
+    n = q;
+    if (minDigits) minDigits--;
+  }
+
+  unsigned int m = (unsigned int)n;
+  while (m > 0xFF) {
+    unsigned int q = (m >> 1) + (m >> 2);
+    q += q >> 4;
+    q += q >> 8;
+    q >>= 3;
+    uint8_t r = (uint8_t)(m - ((q << 3) + (q << 1)));
+    if (r > 9) {
+      q++;
+      r -= 10;
+    }
+    *--str = '0' + r;
+    m = q;
+    if (minDigits) minDigits--;
+  }
+
+  uint8_t b = (uint8_t)m;
+  do {
+    // (b * 205) >> 11 == b / 10 for every 8-bit b
+    uint8_t q = (uint8_t)(((unsigned int)b * 205) >> 11);
+    *--str = '0' + (b - q * 10);
+    b = q;
+    if (minDigits) minDigits--;
+  } while (b);
+
+  while (minDigits--) {
+    *--str = '0';
+  }
+
+  return str;
+}
+
 size_t Print::printNumber(unsigned long n, uint8_t base)
 {
   char buf[8 * sizeof(long) + 1]; // Assumes 8-bit chars plus zero byte.
@@ -210,16 +302,66 @@ size_t Print::printNumber(unsigned long n, uint8_t base)
   // prevent crash if called with base == 1
   if (base < 2) base = 10;
 
-  do {
-    char c = n % base;
-    n /= base;
+  if (base == 10) {
+    str = formatDecimal(n, str, 0);
+  } else if ((base & (base - 1)) == 0) {
+    // HEX, OCT, BIN: shift and mask instead of dividing
+    uint8_t shift = 0;
+    uint8_t mask = base - 1;
+    while ((1 << shift) < base) shift++;
+
+    do {
+      char c = (uint8_t)n & mask;
+      n >>= shift;
+
+      *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while(n);
+  } else {
+    do {
+      char c = n % base;
+      n /= base;
 
-    *--str = c < 10 ? c + '0' : c + 'A' - 10;
-  } while(n);
+      *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while(n);
+  }
 
   return write(str);
 }
 
+// the fraction is converted as one integer when 10^digits fits in 32 bits
+#define PRINT_FLOAT_FIXED_DIGITS 9
+
+// integer part, decimal point and fraction, without the sign
+#define PRINT_FLOAT_CHARS (10 + 1 + PRINT_FLOAT_FIXED_DIGITS)
+
+// Fixed point: round, scale the fraction once, then format the integer part,
+// the decimal point and the zero padded fraction backwards from str.
+// number must be positive and in range, digits <= PRINT_FLOAT_FIXED_DIGITS.
+static char *formatFixed(double number, uint8_t digits, char *str)
+{
+  unsigned long scale = 1;
+
+  for (uint8_t i = 0; i < digits; ++i)
+    scale *= 10;
+
+  // Round correctly so that print(1.999, 2) prints as "2.00"
+  number += 0.5 / (double)scale;
+
+  unsigned long int_part = (unsigned long)number;
+  double remainder = number - (double)int_part;
+
+  if (digits > 0) {
+    unsigned long frac = (unsigned long)(remainder * (double)scale);
+    // guard against the product rounding up to the next integer
+    if (frac >= scale) frac = scale - 1;
+
+    str = formatDecimal(frac, str, digits);
+    *--str = '.';
+  }
+
+  return formatDecimal(int_part, str, 0);
+}
+
 size_t Print::printFloat(double number, uint8_t digits) 
 { 
   size_t n = 0;
@@ -236,6 +378,13 @@ size_t Print::printFloat(double number, uint8_t digits)
      number = -number;
   }
 
+  if (digits <= PRINT_FLOAT_FIXED_DIGITS) {
+    char buf[PRINT_FLOAT_CHARS + 1];
+
+    buf[sizeof(buf) - 1] = '\0';
+    return n + write(formatFixed(number, digits, &buf[sizeof(buf) - 1]));
+  }
+
   // Round correctly so that print(1.999, 2) prints as "2.00"
   double rounding = 0.5;
   for (uint8_t i=0; i<digits; ++i)
@@ -246,6 +395,7 @@ size_t Print::printFloat(double number, uint8_t digits)
   // Extract the integer part of the number and print it
   unsigned long int_part = (unsigned long)number;
   double remainder = number - (double)int_part;
+
   n += print(int_part);
 
   // Print the decimal point, but only if there are digits beyond
@@ -264,3 +414,216 @@ size_t Print::printFloat(double number, uint8_t digits)
   
   return n;
 }
+
+size_t Print::printPadding(char c, int count)
+{
+  size_t n = 0;
+  while (count-- > 0) {
+    n += write(c);
+  }
+  return n;
+}
+
+static inline char readFormat(const char *p, bool inProgmem)
+{
+  return inProgmem ? pgm_read_byte(p) : *p;
+}
+
+// Formats straight into write(): literal text and each converted field are
+// written as they are parsed, so nothing is buffered beyond one number and
+// no heap is used. Supported: flags '-', '0', '+', width, precision and
+// %d %i %u %x %X %c %s %S (string in PROGMEM) %f %%, with the 'l' modifier.
+// %f uses at most PRINT_FLOAT_FIXED_DIGITS digits after the point.
+size_t Print::printFormatted(const char *format, bool inProgmem, va_list args)
+{
+  size_t n = 0;
+  char c;
+
+  while ((c = readFormat(format, inProgmem)) != '\0') {
+    if (c != '%') {
+      const char *start = format;
+      do {
+        format++;
+        c = readFormat(format, inProgmem);
+      } while (c != '\0' && c != '%');
+
+      if (inProgmem) {
+        while (start < format) {
+          n += write(pgm_read_byte(start++));
+        }
+      } else {
+        n += write(start, format - start);
+      }
+      continue;
+    }
+
+    bool leftAlign = false;
+    bool isLong = false;
+    char pad = ' ';
+    char sign = 0;
+    int width = 0;
+    int precision = -1;
+
+    // flags
+    for (;;) {
+      c = readFormat(++format, inProgmem);
+      if (c == '-') leftAlign = true;
+      else if (c == '0') pad = '0';
+      else if (c == '+') sign = '+';
+      else break;
+    }
+
+    while (c >= '0' && c <= '9') {
+      width = width * 10 + (c - '0');
+      c = readFormat(++format, inProgmem);
+    }
+
+    if (c == '.') {
+      precision = 0;
+      c = readFormat(++format, inProgmem);
+      while (c >= '0' && c <= '9') {
+        precision = precision * 10 + (c - '0');
+        c = readFormat(++format, inProgmem);
+      }
+    }
+
+    while (c == 'l' || c == 'h') {
+      if (c == 'l') isLong = true;
+      c = readFormat(++format, inProgmem);
+    }
+
+    if (c == '\0') break;
+    format++;
+
+    // numbers are formatted backwards from the end of buf
+    char buf[PRINT_FLOAT_CHARS];
+    char *end = &buf[sizeof(buf)];
+    char *str = end;
+    const char *text = NULL;
+    bool textInProgmem = false;
+    int len;
+
+    switch (c) {
+      case 'd':
+      case 'i':
+      case 'u': {
+        unsigned long value;
+        if (c == 'u') {
+          value = isLong ? va_arg(args, unsigned long) : va_arg(args, unsigned int);
+          sign = 0;
+        } else {
+          long v = isLong ? va_arg(args, long) : va_arg(args, int);
+          value = v;
+          if (v < 0) {
+            value = -value;
+            sign = '-';
+          }
+        }
+        if (precision > (int)sizeof(buf)) precision = sizeof(buf);
+        // like C, "%.0d" of zero prints nothing
+        if (!(precision == 0 && value == 0)) {
+          str = formatDecimal(value, end, precision > 0 ? precision : 0);
+        }
+        break;
+      }
+
+      case 'x':
+      case 'X': {
+        unsigned long value = isLong ? va_arg(args, unsigned long) : va_arg(args, unsigned int);
+        char letter = (c == 'x') ? 'a' : 'A';
+        sign = 0;
+        if (precision > (int)sizeof(buf)) precision = sizeof(buf);
+        if (!(precision == 0 && value == 0)) {
+          do {
+            uint8_t digit = (uint8_t)value & 0x0F;
+            value >>= 4;
+            *--str = digit < 10 ? digit + '0' : digit + letter - 10;
+          } while (value);
+        }
+        while (end - str < precision) {
+          *--str = '0';
+        }
+        break;
+      }
+
+      case 'c':
+        *--str = (char)va_arg(args, int);
+        sign = 0;
+        pad = ' ';
+        break;
+
+      case 'S':
+        textInProgmem = true;
+        // fall through
+      case 's':
+        text = va_arg(args, const char *);
+        if (text == NULL) {
+          text = "(null)";
+          textInProgmem = false;
+        }
+        sign = 0;
+        pad = ' ';
+        break;
+
+      case 'f': {
+        double number = va_arg(args, double);
+        if (precision < 0) precision = 6;
+        if (precision > PRINT_FLOAT_FIXED_DIGITS) precision = PRINT_FLOAT_FIXED_DIGITS;
+
+        if (number < 0.0) {
+          number = -number;
+          sign = '-';
+        }
+
+        if (isnan(number)) text = "nan";
+        else if (isinf(number)) text = "inf";
+        else if (number > 4294967040.0) text = "ovf";  // same limit as printFloat()
+        else str = formatFixed(number, precision, end);
+
+        if (text != NULL) {
+          sign = 0;
+          pad = ' ';
+        }
+        break;
+      }
+
+      default:
+        // "%%", and unknown conversions are printed as they are
+        n += write(c);
+        continue;
+    }
+
+    if (text != NULL) {
+      // precision limits the number of characters taken from a string
+      if (textInProgmem) {
+        len = (precision >= 0) ? strnlen_P(text, precision) : strlen_P(text);
+      } else {
+        len = (precision >= 0) ? strnlen(text, precision) : strlen(text);
+      }
+    } else {
+      len = end - str;
+      // the 0 flag is ignored when a precision is given for an integer
+      if (precision >= 0 && c != 'f') pad = ' ';
+    }
+
+    int padding = width - len - (sign ? 1 : 0);
+
+    if (!leftAlign && pad == ' ') n += printPadding(' ', padding);
+    if (sign) n += write(sign);
+    if (!leftAlign && pad == '0') n += printPadding('0', padding);
+
+    if (text == NULL) {
+      n += write(str, len);
+    } else if (textInProgmem) {
+      for (int i = 0; i < len; i++) {
+        n += write(pgm_read_byte(text + i));
+      }
+    } else {
+      n += write(text, len);
+    }
+
+    if (leftAlign) n += printPadding(' ', padding);
+  }
+
+  return n;
+}
@@ -22,6 +22,7 @@
 
 #include <inttypes.h>
 #include <stdio.h> // for size_t
+#include <stdarg.h>
 
 #include "WString.h"
 #include "Printable.h"
@@ -37,6 +38,8 @@ class Print
     int write_error;
     size_t printNumber(unsigned long, uint8_t);
     size_t printFloat(double, uint8_t);
+    size_t printFormatted(const char *, bool, va_list);
+    size_t printPadding(char, int);
   protected:
     void setWriteError(int err = 1) { write_error = err; }
   public:
@@ -79,6 +82,16 @@ class Print
     size_t println(double, int = 2);
     size_t println(const Printable&);
     size_t println(void);
+
+    // Formatted output written straight to write(), without a buffer or the heap.
+    // Supports %d %i %u %x %X %c %s %S %f %% with flags '-' '0' '+', width,
+    // precision and the 'l' modifier. %S takes a string in PROGMEM.
+    // The _P and F() forms read the format string from flash.
+    size_t printf(const char *, ...);
+    size_t printf(const __FlashStringHelper *, ...);
+    size_t printf_P(PGM_P, ...);
+    size_t vprintf(const char *, va_list);
+    size_t vprintf_P(PGM_P, va_list);
 };
 
 #endif
@@ -0,0 +1,366 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+#include "wiring_private.h"
+#include "pins_arduino.h"
+#include "PinChangeInterrupt.h"
+#include "PulseService.h"
+
+#if (CONFIG_USE_PULSE_SERVICE == 1) && defined(TIMSK1) && defined(ICR1)
+
+// ICP1のピン番号
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__)
+    #define PULSE_ICP_PIN 8
+#elif defined(__AVR_ATmega32U4__)
+    #define PULSE_ICP_PIN 4
+#endif
+
+// PulseChannel.sourceの値
+#define PULSE_SOURCE_ICP 0
+#define PULSE_SOURCE_PIN_CHANGE 1
+
+typedef struct
+{
+    // NULLのとき, 使用されていない.
+    QueueHandle queue;
+
+    uint8_t pin;
+    uint8_t mode;
+    uint8_t source;
+
+    // 測定中のパルスの始まりの時刻.
+    uint8_t started;
+    uint32_t startTime;
+
+    unsigned short overrunCount;
+} PulseChannel;
+
+static PulseChannel channels[PULSE_MAX_CHANNELS];
+static PulseChannel *icpChannel = NULL;
+static uint8_t activeChannelCount = 0;
+
+// Timer1のオーバーフロー回数. カウントの上位16bitになる.
+static volatile uint16_t overflowCount;
+
+// 測定前のTimer1の設定
+static uint8_t savedTCCR1A, savedTCCR1B, savedTIMSK1;
+
+//
+// Timer1のカウントに上位16bitを付けます. 割り込み禁止中に呼んでください.
+// countはオーバーフロー割り込みが保留されている間に記録されたものでもかまいません.
+//
+static uint32_t ExtendCount(uint16_t count)
+{
+    uint16_t high = overflowCount;
+
+    // オーバーフローが保留されていて, countがオーバーフローの後に記録された値なら1周分進める.
+    if ((TIFR1 & _BV(TOV1)) && (count < 0x8000))
+    {
+        high++;
+    }
+
+    return ((uint32_t)high << 16) | count;
+}
+
+// Timer1のカウント(8クロック)をusに変換する.
+static unsigned long CountToMicros(uint32_t count)
+{
+    return (count / clockCyclesPerMicrosecond()) * 8UL +
+        ((count % clockCyclesPerMicrosecond()) * 8UL) / clockCyclesPerMicrosecond();
+}
+
+static void SendResult(PulseChannel *channel, uint32_t count, signed PortBaseType *higherPriorityTaskWoken)
+{
+    if ((QueueSendFromISR(channel->queue, &count, higherPriorityTaskWoken) != PD_PASS) &&
+        (channel->overrunCount != 0xffff))
+    {
+        channel->overrunCount++;
+    }
+}
+
+//
+// エッジを処理します. levelはエッジの後のピンの状態.
+//
+static void HandleEdge(PulseChannel *channel, uint8_t level, uint32_t time, signed PortBaseType *higherPriorityTaskWoken)
+{
+    if (channel->mode == PULSE_PERIOD)
+    {
+        if (level)
+        {
+            if (channel->started)
+            {
+                SendResult(channel, time - channel->startTime, higherPriorityTaskWoken);
+            }
+            channel->startTime = time;
+            channel->started = 1;
+        }
+        return;
+    }
+
+    if (level == ((channel->mode == PULSE_HIGH_WIDTH) ? 1 : 0))
+    {
+        channel->startTime = time;
+        channel->started = 1;
+    }
+    else if (channel->started)
+    {
+        channel->started = 0;
+        SendResult(channel, time - channel->startTime, higherPriorityTaskWoken);
+    }
+}
+
+static PulseChannel *FindChannel(uint8_t pin)
+{
+    PulseChannel *channel;
+
+    for (channel = channels; channel < &channels[PULSE_MAX_CHANNELS]; channel++)
+    {
+        if ((channel->queue != NULL) && (channel->pin == pin))
+        {
+            return channel;
+        }
+    }
+
+    return NULL;
+}
+
+#if (CONFIG_USE_PIN_CHANGE_INTERRUPTS == 1)
+//
+// ピン変化割り込みから呼ばれる.
+//
+static void PinChanged(uint8_t pin, uint8_t state, signed PortBaseType *higherPriorityTaskWoken)
+{
+    PulseChannel *channel = FindChannel(pin);
+
+    if (channel != NULL)
+    {
+        HandleEdge(channel, state, ExtendCount(TCNT1), higherPriorityTaskWoken);
+    }
+}
+#endif
+
+ISR(TIMER1_OVF_vect)
+{
+    overflowCount++;
+}
+
+#if defined(PULSE_ICP_PIN)
+ISR_WAKING_TASK(TIMER1_CAPT_vect)
+{
+    signed PortBaseType higherPriorityTaskWoken = PD_FALSE;
+    uint16_t count = ICR1;
+    uint8_t level = bit_is_set(TCCR1B, ICES1) ? 1 : 0;
+
+    if (icpChannel != NULL)
+    {
+        if (icpChannel->mode != PULSE_PERIOD)
+        {
+            // パルスの終わりを捕える. エッジを変えた後はフラグを消す.
+            TCCR1B ^= _BV(ICES1);
+            TIFR1 = _BV(ICF1);
+        }
+
+        HandleEdge(icpChannel, level, ExtendCount(count), &higherPriorityTaskWoken);
+    }
+
+    YieldFromISR(higherPriorityTaskWoken);
+}
+#endif
+
+signed PortBaseType PulseAttach(uint8_t pin, uint8_t mode, unsigned PortBaseType queueLength)
+{
+    PulseChannel *channel;
+    QueueHandle queue;
+    uint8_t source;
+
+    if ((mode > PULSE_PERIOD) || (queueLength == 0) || (FindChannel(pin) != NULL))
+    {
+        return PD_FAIL;
+    }
+
+    for (channel = channels; channel < &channels[PULSE_MAX_CHANNELS]; channel++)
+    {
+        if (channel->queue == NULL)
+        {
+            break;
+        }
+    }
+
+    if (channel == &channels[PULSE_MAX_CHANNELS])
+    {
+        return PD_FAIL;
+    }
+
+#if defined(PULSE_ICP_PIN)
+    if (pin == PULSE_ICP_PIN)
+    {
+        source = PULSE_SOURCE_ICP;
+    }
+    else
+#endif
+#if (CONFIG_USE_PIN_CHANGE_INTERRUPTS == 1)
+    if (digitalPinToPCICR(pin) != NULL)
+    {
+        source = PULSE_SOURCE_PIN_CHANGE;
+    }
+    else
+#endif
+    {
+        return PD_FAIL;
+    }
+
+    // Timer1がtickやADCのスキャンなどに使われているときは失敗する.
+    if (TimerAcquire(1, TIMER_OWNER_PULSE) != PD_PASS)
+    {
+        return PD_FAIL;
+    }
+
+    queue = QueueCreate(queueLength, sizeof(uint32_t));
+    if (queue == NULL)
+    {
+        if (activeChannelCount == 0)
+        {
+            TimerRelease(1, TIMER_OWNER_PULSE);
+        }
+        return PD_FAIL;
+    }
+
+    EnterCritical();
+    {
+        if (activeChannelCount++ == 0)
+        {
+            savedTCCR1A = TCCR1A;
+            savedTCCR1B = TCCR1B;
+            savedTIMSK1 = TIMSK1;
+
+            // Timer1: ノーマルモード, 分周8. オーバーフローでカウントの上位を数える.
+            TIMSK1 = 0;
+            TCCR1B = 0;
+            TCCR1A = 0;
+            TCNT1 = 0;
+            overflowCount = 0;
+            TIFR1 = _BV(TOV1) | _BV(ICF1);
+            TIMSK1 = _BV(TOIE1);
+            TCCR1B = _BV(CS11);
+        }
+
+        channel->pin = pin;
+        channel->mode = mode;
+        channel->source = source;
+        channel->started = 0;
+        channel->overrunCount = 0;
+        channel->queue = queue;
+
+        if (source == PULSE_SOURCE_ICP)
+        {
+            // ノイズキャンセラを使用し, パルスの始まりのエッジから捕える.
+            if (mode == PULSE_LOW_WIDTH)
+            {
+                TCCR1B = (TCCR1B & ~_BV(ICES1)) | _BV(ICNC1);
+            }
+            else
+            {
+                TCCR1B |= _BV(ICNC1) | _BV(ICES1);
+            }
+            icpChannel = channel;
+            TIFR1 = _BV(ICF1);
+            TIMSK1 |= _BV(ICIE1);
+        }
+    }
+    ExitCritical();
+
+#if (CONFIG_USE_PIN_CHANGE_INTERRUPTS == 1)
+    // エッジの向きはHandleEdge()で見分ける.
+    if ((source == PULSE_SOURCE_PIN_CHANGE) && (PinChangeAttach(pin, PinChanged, CHANGE) != PD_PASS))
+    {
+        PulseDetach(pin);
+        return PD_FAIL;
+    }
+#endif
+
+    return PD_PASS;
+}
+
+void PulseDetach(uint8_t pin)
+{
+    PulseChannel *channel = FindChannel(pin);
+    QueueHandle queue;
+
+    if (channel == NULL)
+    {
+        return;
+    }
+
+#if (CONFIG_USE_PIN_CHANGE_INTERRUPTS == 1)
+    if (channel->source == PULSE_SOURCE_PIN_CHANGE)
+    {
+        PinChangeDetach(pin);
+    }
+#endif
+
+    EnterCritical();
+    {
+        if (channel->source == PULSE_SOURCE_ICP)
+        {
+            TIMSK1 &= ~_BV(ICIE1);
+            icpChannel = NULL;
+        }
+
+        queue = channel->queue;
+        channel->queue = NULL;
+
+        if (--activeChannelCount == 0)
+        {
+            TCCR1B = 0;
+            TCCR1A = savedTCCR1A;
+            TIMSK1 = savedTIMSK1;
+            TCCR1B = savedTCCR1B;
+            TimerRelease(1, TIMER_OWNER_PULSE);
+        }
+    }
+    ExitCritical();
+
+    QueueDelete(queue);
+}
+
+signed PortBaseType PulseRead(uint8_t pin, unsigned long *microseconds, PortTickType ticksToWait)
+{
+    PulseChannel *channel = FindChannel(pin);
+    uint32_t count;
+
+    if (channel == NULL)
+    {
+        return PD_FAIL;
+    }
+
+    if (!taskCanBlock())
+    {
+        ticksToWait = 0;
+    }
+
+    if (QueueReceive(channel->queue, &count, ticksToWait) != PD_PASS)
+    {
+        return PD_FAIL;
+    }
+
+    *microseconds = CountToMicros(count);
+    return PD_PASS;
+}
+
+unsigned short PulseGetOverrunCount(uint8_t pin)
+{
+    PulseChannel *channel = FindChannel(pin);
+
+    return (channel == NULL) ? 0 : channel->overrunCount;
+}
+
+#endif
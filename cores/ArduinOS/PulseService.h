@@ -0,0 +1,135 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+
+/*
+// パルス測定サービス
+//
+// CONFIG_USE_PULSE_SERVICE が1のとき, パルスの幅と周期を割り込みで測定します.
+// pulseIn()のように測定中に待ち続けないため, 測定を待つタスクは他のタスクの実行を妨げません.
+//
+// 割り込みでエッジの時刻を記録し, 測定結果をピンごとのキューでタスクに渡します.
+// 複数のピンを同時に測定できます.
+//  - ICP1のピン(UNOでは8番, Leonardoでは4番)はTimer1のインプットキャプチャで測定します.
+//    エッジの時刻はハードウェアで記録されるため, 割り込みの遅れの影響を受けません.
+//  - その他のピンはピン変化割り込み(PinChangeInterrupt.h)で測定します. 時刻は割り込みの中で記録されます.
+//    CONFIG_USE_PIN_CHANGE_INTERRUPTS が0のときは使用できません.
+//
+// 時刻はTimer1(分周8. 16Mhzでは0.5us)で測定します.
+// 測定中はTimer1を使用できません(9, 10番ピンのanalogWrite(), Servoライブラリ, AdcScanStart()など).
+// Timer1がtickやADCのスキャンなど, 他に使用されているとき(TimerManager.h)は測定を開始できません.
+//
+// 割り込みが遅れたときにエッジを見逃さないよう, パルスの幅は数十us以上にしてください.
+*/
+
+#ifndef PULSE_SERVICE_H
+#define PULSE_SERVICE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (CONFIG_USE_PULSE_SERVICE == 1)
+
+    // 測定の種類
+#define PULSE_HIGH_WIDTH 0 // 立ち上がりから立ち下がりまで
+#define PULSE_LOW_WIDTH 1  // 立ち下がりから立ち上がりまで
+#define PULSE_PERIOD 2     // 立ち上がりから次の立ち上がりまで
+
+    // 同時に測定できるピンの最大数
+#define PULSE_MAX_CHANNELS 4
+
+    /*
+    // ピンの測定を開始します.
+    // ピンのモード(INPUT, INPUT_PULLUP)は呼び出し側で設定してください.
+    //
+    // @param pin:
+    //  測定するピン. ICP1のピンか, ピン変化割り込みを使用できるピン.
+    //
+    // @param mode:
+    //  PULSE_HIGH_WIDTH, PULSE_LOW_WIDTH, PULSE_PERIOD のいずれか.
+    //
+    // @param queueLength:
+    //  読み取られるまで溜めておける測定結果の数.
+    //  キューはsizeof(unsigned long) * queueLength byteを使用します.
+    //
+    // @return:
+    //  PD_PASS if the measurement was started, otherwise PD_FAIL.
+    //
+    // Example usage:
+
+    #define ECHO_PIN 8
+
+    TaskLoop(distanceTask)
+    {
+        unsigned long width;
+
+        // トリガーを送り, エコーのパルス幅を待つ.
+        digitalWrite(TRIGGER_PIN, HIGH);
+        delayMicroseconds(10);
+        digitalWrite(TRIGGER_PIN, LOW);
+
+        if (PulseRead(ECHO_PIN, &width, 30) == PD_PASS)
+        {
+            Serial.println(width / 58); // cm
+        }
+        TaskDelayMillis(60);
+    }
+
+    void setup()
+    {
+        pinMode(ECHO_PIN, INPUT);
+        PulseAttach(ECHO_PIN, PULSE_HIGH_WIDTH, 1);
+        CreateTaskLoop(distanceTask, NORMAL_PRIORITY);
+    }
+    */
+    signed PortBaseType PulseAttach(uint8_t pin, uint8_t mode, unsigned PortBaseType queueLength);
+
+    /*
+    // ピンの測定を終了し, キューを削除します.
+    // 最後のピンの測定を終了すると, Timer1の設定は最初のPulseAttach()を呼ぶ前の状態に戻ります.
+    // PulseRead()で待っているタスクがないときに呼んでください.
+    */
+    void PulseDetach(uint8_t pin);
+
+    /*
+    // 測定結果を受け取ります.
+    // 測定結果がないときは, 測定が終わるかタイムアウトするまでタスクをブロックします.
+    //
+    // @param pin:
+    //  PulseAttach()で測定を開始したピン.
+    //
+    // @param microseconds:
+    //  測定結果(us)の格納先.
+    //
+    // @param ticksToWait:
+    //  待つ最大のtick数. ブロックできない状態(割り込み関数の中やsetup()の中など)では待ちません.
+    //
+    // @return:
+    //  PD_PASS if a result was received, otherwise PD_FAIL.
+    */
+    signed PortBaseType PulseRead(uint8_t pin, unsigned long *microseconds, PortTickType ticksToWait);
+
+    /*
+    // キューがいっぱいで捨てられた測定結果の数を返します.
+    */
+    unsigned short PulseGetOverrunCount(uint8_t pin);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,138 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+#include "wiring_private.h"
+#include "pins_arduino.h"
+#include "TimerManager.h"
+
+#if defined(TCCR5A)
+    #define TIMER_COUNT 6
+#elif defined(TCCR4A)
+    #define TIMER_COUNT 5
+#elif defined(TCCR3A)
+    #define TIMER_COUNT 4
+#else
+    #define TIMER_COUNT 3
+#endif
+
+// tickのタイマーはスケジューラが動き出す前から予約しておく.
+static volatile uint8_t timerOwners[TIMER_COUNT] = {
+    TIMER_OWNER_SYSTEM,
+
+#if (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER1)
+    TIMER_OWNER_KERNEL,
+#else
+    TIMER_OWNER_PWM,
+#endif
+
+#if !defined(TCCR2A) && !defined(TCCR2)
+    TIMER_OWNER_NOT_PRESENT,
+#elif (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER2)
+    TIMER_OWNER_KERNEL,
+#else
+    TIMER_OWNER_PWM,
+#endif
+
+#if (TIMER_COUNT > 3)
+    TIMER_OWNER_PWM,
+#endif
+#if (TIMER_COUNT > 4)
+    TIMER_OWNER_PWM,
+#endif
+#if (TIMER_COUNT > 5)
+    TIMER_OWNER_PWM,
+#endif
+};
+
+signed PortBaseType TimerAcquire(uint8_t timer, uint8_t owner)
+{
+    signed PortBaseType ret = PD_FAIL;
+
+    if ((timer >= TIMER_COUNT) || (owner == TIMER_OWNER_PWM))
+    {
+        return PD_FAIL;
+    }
+
+    EnterCritical();
+    {
+        if ((timerOwners[timer] == TIMER_OWNER_PWM) || (timerOwners[timer] == owner))
+        {
+            timerOwners[timer] = owner;
+            ret = PD_PASS;
+        }
+    }
+    ExitCritical();
+
+    return ret;
+}
+
+void TimerRelease(uint8_t timer, uint8_t owner)
+{
+    if ((timer >= TIMER_COUNT) || (owner == TIMER_OWNER_SYSTEM) || (owner == TIMER_OWNER_KERNEL))
+    {
+        return;
+    }
+
+    EnterCritical();
+    {
+        if (timerOwners[timer] == owner)
+        {
+            timerOwners[timer] = TIMER_OWNER_PWM;
+        }
+    }
+    ExitCritical();
+}
+
+uint8_t TimerGetOwner(uint8_t timer)
+{
+    return (timer < TIMER_COUNT) ? timerOwners[timer] : TIMER_OWNER_NOT_PRESENT;
+}
+
+uint8_t TimerOfPin(uint8_t pin)
+{
+    uint8_t channel = digitalPinToTimer(pin);
+
+    // TIMER0A, TIMER0B, TIMER1A, ... の順に並んでいる.
+    if (channel == NOT_ON_TIMER)
+    {
+        return TIMER_NONE;
+    }
+    else if (channel <= TIMER0B)
+    {
+        return 0;
+    }
+    else if (channel <= TIMER1C)
+    {
+        return 1;
+    }
+    else if (channel <= TIMER2B)
+    {
+        return 2;
+    }
+    else if (channel <= TIMER3C)
+    {
+        return 3;
+    }
+    else if (channel <= TIMER4D)
+    {
+        return 4;
+    }
+
+    return 5;
+}
+
+uint8_t TimerPwmAvailable(uint8_t timer)
+{
+    uint8_t owner = TimerGetOwner(timer);
+
+    return (owner == TIMER_OWNER_PWM) || (owner == TIMER_OWNER_SYSTEM);
+}
@@ -0,0 +1,108 @@
+/*
+// ArduinOS
+//
+// ArduinOSとは, リアルタイムOS(RTOS)を理解するために, もともとあるFreeRTOSから
+// 必要な機能を抜き出し, Arduinoの開発環境で使用できるようにしたものです.
+//
+// GNU General Public License(ver2) が適用されています.
+//
+// ArduinOSに関する詳しい説明は以下のページを参照してください.
+// http://webviewer.php.xdomain.jp/?contentPath=./Contents/Arduino/ArduinOS/ArduinOS.html
+//
+*/
+
+/*
+// タイマー管理
+//
+// ハードウェアタイマー(Timer0, 1, 2. ATmega2560では3, 4, 5も)の使用者を記録し,
+// tone(), パルス測定, ADCのスキャンなどが同じタイマーを同時に設定し直さないようにします.
+//
+// 起動時の使用者:
+//  Timer0: TIMER_OWNER_SYSTEM. millis(), micros()(CONFIG_TICK_SOURCE が PORT_TICK_SOURCE_TIMER0 のときはtickも).
+//  CONFIG_TICK_SOURCE のTimer1, Timer2: TIMER_OWNER_KERNEL.
+//  その他のタイマー: TIMER_OWNER_PWM. init()がanalogWrite()のために設定したままの状態です.
+//
+// TIMER_OWNER_SYSTEM, TIMER_OWNER_KERNEL のタイマーは取得できません.
+// analogWrite()は, TIMER_OWNER_PWM と TIMER_OWNER_SYSTEM のタイマーのピンだけでPWMを出力します.
+// それ以外のタイマーのピンでは, digitalWrite()と同じく HIGH か LOW を出力します.
+//
+// タイマーを設定し直すライブラリやスケッチは, 設定の前にTimerAcquire()で取得してください.
+*/
+
+#ifndef TIMER_MANAGER_H
+#define TIMER_MANAGER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    // タイマーの使用者
+#define TIMER_OWNER_PWM 0          // init()の設定のまま. 取得できる.
+#define TIMER_OWNER_SYSTEM 1       // millis(), micros(). PWMは使用できる.
+#define TIMER_OWNER_KERNEL 2       // tick
+#define TIMER_OWNER_TONE 3         // tone()
+#define TIMER_OWNER_ADC_SCAN 4     // AdcScanStart()
+#define TIMER_OWNER_PULSE 5        // PulseAttach()
+#define TIMER_OWNER_USER 6         // ライブラリ, スケッチ
+#define TIMER_OWNER_NOT_PRESENT 0xff
+
+    // TimerOfPin()でタイマーがないとき
+#define TIMER_NONE 0xff
+
+    /*
+    // タイマーを取得します.
+    // 使用者が TIMER_OWNER_PWM のとき, またはすでにownerが取得しているときに成功します.
+    // 割り込み関数の中からも呼べます.
+    //
+    // @param timer:
+    //  タイマーの番号(0, 1, 2, ...).
+    //
+    // @param owner:
+    //  TIMER_OWNER_TONE などの使用者.
+    //
+    // @return:
+    //  PD_PASS if the timer was acquired, otherwise PD_FAIL.
+    //
+    // Example usage:
+
+    if (TimerAcquire(2, TIMER_OWNER_USER) == PD_PASS)
+    {
+        // Timer2を設定する.
+        // ...
+
+        // 使用後はinit()の設定(8bit位相基準PWM, 分周64)に戻してから解放する.
+        TimerRelease(2, TIMER_OWNER_USER);
+    }
+    */
+    signed PortBaseType TimerAcquire(uint8_t timer, uint8_t owner);
+
+    /*
+    // ownerが取得したタイマーを解放し, 使用者を TIMER_OWNER_PWM に戻します.
+    // タイマーの設定は, 呼び出し側でinit()の設定に戻してください.
+    // ownerが取得していないときは何もしません.
+    */
+    void TimerRelease(uint8_t timer, uint8_t owner);
+
+    /*
+    // タイマーの使用者を返します.
+    // 存在しないタイマーでは TIMER_OWNER_NOT_PRESENT を返します.
+    */
+    uint8_t TimerGetOwner(uint8_t timer);
+
+    /*
+    // ピンのPWMに使用されるタイマーの番号を返します. PWMのピンでないときは TIMER_NONE.
+    */
+    uint8_t TimerOfPin(uint8_t pin);
+
+    /*
+    // タイマーでanalogWrite()のPWMを出力できるかを返します.
+    */
+    uint8_t TimerPwmAvailable(uint8_t timer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
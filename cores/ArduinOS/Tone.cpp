@@ -88,12 +88,20 @@ volatile uint8_t timer5_pin_mask;
 #endif
 
 
+// Timer2 is used for the kernel tick when CONFIG_TICK_SOURCE is
+// PORT_TICK_SOURCE_TIMER2, so tones are played on timer 1 instead.
+#if (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER2)
+#define TONE_TIMER 1
+#else
+#define TONE_TIMER 2
+#endif
+
 #if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
 
 #define AVAILABLE_TONE_PINS 1
 #define USE_TIMER2
 
-const uint8_t PROGMEM tone_pin_to_timer_PGM[] = { 2 /*, 3, 4, 5, 1, 0 */ };
+const uint8_t PROGMEM tone_pin_to_timer_PGM[] = { TONE_TIMER /*, 3, 4, 5, 1, 0 */ };
 static uint8_t tone_pins[AVAILABLE_TONE_PINS] = { 255 /*, 255, 255, 255, 255, 255 */ };
 
 #elif defined(__AVR_ATmega8__)
@@ -101,7 +109,7 @@ static uint8_t tone_pins[AVAILABLE_TONE_PINS] = { 255 /*, 255, 255, 255, 255, 25
 #define AVAILABLE_TONE_PINS 1
 #define USE_TIMER2
 
-const uint8_t PROGMEM tone_pin_to_timer_PGM[] = { 2 /*, 1 */ };
+const uint8_t PROGMEM tone_pin_to_timer_PGM[] = { TONE_TIMER /*, 1 */ };
 static uint8_t tone_pins[AVAILABLE_TONE_PINS] = { 255 /*, 255 */ };
 
 #elif defined(__AVR_ATmega32U4__)
@@ -118,11 +126,16 @@ static uint8_t tone_pins[AVAILABLE_TONE_PINS] = { 255 /*, 255 */ };
 #define USE_TIMER2
 
 // Leave timer 0 to last.
-const uint8_t PROGMEM tone_pin_to_timer_PGM[] = { 2 /*, 1, 0 */ };
+const uint8_t PROGMEM tone_pin_to_timer_PGM[] = { TONE_TIMER /*, 1, 0 */ };
 static uint8_t tone_pins[AVAILABLE_TONE_PINS] = { 255 /*, 255, 255 */ };
 
 #endif
 
+#if (TONE_TIMER == 1) && defined(USE_TIMER2)
+#undef USE_TIMER2
+#define USE_TIMER1
+#endif
+
 
 
 static int8_t toneBegin(uint8_t _pin)
@@ -136,12 +149,16 @@ static int8_t toneBegin(uint8_t _pin)
     }
   }
   
-  // search for an unused timer.
+  // search for an unused timer.  a timer held by another owner (the kernel
+  // tick, pulse measurement, ADC scan, ...) is left alone.
   for (int i = 0; i < AVAILABLE_TONE_PINS; i++) {
     if (tone_pins[i] == 255) {
-      tone_pins[i] = _pin;
       _timer = pgm_read_byte(tone_pin_to_timer_PGM + i);
-      break;
+      if (TimerAcquire(_timer, TIMER_OWNER_TONE) == PD_PASS) {
+        tone_pins[i] = _pin;
+        break;
+      }
+      _timer = -1;
     }
   }
   
@@ -438,6 +455,11 @@ void disableTimer(uint8_t _timer)
 #if defined(TIMSK1) && defined(OCIE1A)
     case 1:
       bitWrite(TIMSK1, OCIE1A, 0);
+      #if defined(TCCR1A) && defined(WGM10) && defined(CS11) && defined(CS10)
+        // back to the 8-bit phase correct pwm set up by init()
+        TCCR1A = (1 << WGM10);
+        TCCR1B = (1 << CS11) | (F_CPU >= 8000000L ? (1 << CS10) : 0);
+      #endif
       break;
 #endif
 
@@ -489,7 +511,14 @@ void noTone(uint8_t _pin)
     }
   }
   
+  if (_timer < 0) {
+    // not playing on this pin; the timer may belong to someone else.
+    digitalWrite(_pin, 0);
+    return;
+  }
+
   disableTimer(_timer);
+  TimerRelease(_timer, TIMER_OWNER_TONE);
 
   digitalWrite(_pin, 0);
 }
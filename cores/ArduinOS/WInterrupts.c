@@ -67,9 +67,89 @@ static volatile voidFuncPtr intFunc[EXTERNAL_NUM_INTERRUPTS] = {
 };
 // volatile static voidFuncPtr twiIntFunc;
 
+#if (CONFIG_USE_DEFERRED_INTERRUPTS == 1)
+typedef void (*deferredFuncPtr)(uint16_t, unsigned long);
+
+// NULLでないとき, 割り込みは割り込み処理タスクで処理される.
+static volatile deferredFuncPtr deferredFunc[EXTERNAL_NUM_INTERRUPTS];
+
+// 割り込み処理タスクが処理するまでのエッジの数と, 最後のエッジの時刻(micros()).
+static volatile uint16_t deferredCount[EXTERNAL_NUM_INTERRUPTS];
+static volatile unsigned long deferredTime[EXTERNAL_NUM_INTERRUPTS];
+
+// 処理を待っている割り込みのビット
+static volatile uint8_t deferredPending = 0;
+static volatile uint8_t deferredWaiting = 0;
+
+static SemaphoreHandle deferredSemaphore = NULL;
+static TaskHandle deferredTask = NULL;
+
+// 割り込み関数から呼ばれる. エッジを記録し, 割り込み処理タスクを起こすだけにする.
+static inline void deferInterrupt(uint8_t interruptNum) {
+  signed PortBaseType higherPriorityTaskWoken = PD_FALSE;
+
+  deferredTime[interruptNum] = micros();
+  if (deferredCount[interruptNum] != 0xffff) {
+    deferredCount[interruptNum]++;
+  }
+  deferredPending |= (1 << interruptNum);
+
+  if (deferredWaiting) {
+    deferredWaiting = 0;
+    SemaphoreGiveFromISR(deferredSemaphore, &higherPriorityTaskWoken);
+  }
+
+  YieldFromISR(higherPriorityTaskWoken);
+}
+
+static void deferredInterruptTask(void *parameters) {
+  deferredFuncPtr func;
+  uint16_t count;
+  unsigned long time;
+  uint8_t pending;
+  uint8_t i;
+
+  (void)parameters;
+
+  for (;;) {
+    EnterCritical();
+    pending = deferredPending;
+    deferredPending = 0;
+    // 割り込みに起こしてもらうため, 確認と同時に待っていることを知らせる.
+    deferredWaiting = (pending == 0);
+    ExitCritical();
+
+    if (pending == 0) {
+      SemaphoreTake(deferredSemaphore, PORT_MAX_DELAY);
+      continue;
+    }
+
+    for (i = 0; i < EXTERNAL_NUM_INTERRUPTS; i++) {
+      if (!(pending & (1 << i))) {
+        continue;
+      }
+
+      EnterCritical();
+      func = deferredFunc[i];
+      count = deferredCount[i];
+      time = deferredTime[i];
+      deferredCount[i] = 0;
+      ExitCritical();
+
+      if ((func != NULL) && (count != 0)) {
+        func(count, time);
+      }
+    }
+  }
+}
+#endif
+
 void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode) {
   if(interruptNum < EXTERNAL_NUM_INTERRUPTS) {
     intFunc[interruptNum] = userFunc;
+#if (CONFIG_USE_DEFERRED_INTERRUPTS == 1)
+    deferredFunc[interruptNum] = NULL;
+#endif
     
     // Configure the interrupt mode (trigger on low input, any change, rising
     // edge, or falling edge).  The mode constants were chosen to correspond
@@ -271,8 +351,73 @@ void detachInterrupt(uint8_t interruptNum) {
     }
       
     intFunc[interruptNum] = nothing;
+#if (CONFIG_USE_DEFERRED_INTERRUPTS == 1)
+    deferredFunc[interruptNum] = NULL;
+#endif
+  }
+}
+
+#if (CONFIG_USE_DEFERRED_INTERRUPTS == 1)
+/*
+// attachInterrupt()と同じように外部割り込みを設定しますが, userFuncは割り込み処理タスクから呼ばれます.
+// 割り込み関数はエッジの数と時刻を記録し, 割り込み処理タスクを起こすだけです.
+// そのため, userFuncの中ではキューやSerialなど, すべてのAPIを使用できます.
+// 割り込み処理タスクの優先度は CONFIG_DEFERRED_INTERRUPT_PRIORITY です.
+//
+// userFuncが呼ばれる前に複数のエッジが起きた場合は, まとめて1回呼ばれます.
+//
+// @param userFunc:
+//  edgeCount: 前回呼ばれてからのエッジの数(最大0xffff).
+//  timestamp: 最後のエッジのmicros().
+//
+// 割り込み処理タスクを作成できなかったときは, 割り込みを有効にしません.
+//
+// Example usage:
+
+volatile long position = 0;
+
+void onStep(uint16_t edgeCount, unsigned long timestamp)
+{
+    position += edgeCount;
+    Serial.println(timestamp);
+}
+
+void setup()
+{
+    Serial.begin(9600);
+    attachInterruptDeferred(digitalPinToInterrupt(2), onStep, RISING);
+}
+*/
+void attachInterruptDeferred(uint8_t interruptNum, void (*userFunc)(uint16_t edgeCount, unsigned long timestamp), int mode) {
+  if (interruptNum >= EXTERNAL_NUM_INTERRUPTS) {
+    return;
   }
+
+  if (deferredTask == NULL) {
+    if (deferredSemaphore == NULL) {
+      SemaphoreCreateBinary(deferredSemaphore);
+      if (deferredSemaphore == NULL) {
+        return;
+      }
+    }
+
+    if (TaskCreate(deferredInterruptTask, (signed PortChar *)"Interrupt", CONFIG_DEFERRED_INTERRUPT_STACK_SIZE,
+                   NULL, CONFIG_DEFERRED_INTERRUPT_PRIORITY, &deferredTask) != PD_PASS) {
+      deferredTask = NULL;
+      return;
+    }
+  }
+
+  // 割り込みを設定してから, 処理をタスクに切り替える.
+  attachInterrupt(interruptNum, nothing, mode);
+
+  uint8_t oldSREG = SREG;
+  cli();
+  deferredCount[interruptNum] = 0;
+  deferredFunc[interruptNum] = userFunc;
+  SREG = oldSREG;
 }
+#endif
 
 /*
 void attachInterruptTwi(void (*userFunc)(void) ) {
@@ -280,10 +425,22 @@ void attachInterruptTwi(void (*userFunc)(void) ) {
 }
 */
 
+// CONFIG_USE_ISR_YIELDが1のとき, 登録された関数からYieldFromISR()を使用できる.
+#if (CONFIG_USE_DEFERRED_INTERRUPTS == 1)
+#define IMPLEMENT_ISR(vect, interrupt) \
+  ISR_WAKING_TASK(vect) { \
+    if (deferredFunc[interrupt] != NULL) { \
+      deferInterrupt(interrupt); \
+    } else { \
+      intFunc[interrupt](); \
+    } \
+  }
+#else
 #define IMPLEMENT_ISR(vect, interrupt) \
-  ISR(vect) { \
+  ISR_WAKING_TASK(vect) { \
     intFunc[interrupt](); \
   }
+#endif
 
 #if defined(__AVR_ATmega32U4__)
 
@@ -16,6 +16,25 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
+#include "wiring_private.h"
+
+#if (CONFIG_USE_TASK_DELAY_IN_DELAY == 1)
+/**
+ * yield() hook bound to TaskYield().
+ *
+ * Libraries that call yield() while waiting let other tasks of the same
+ * priority run. Nothing is done from an ISR, inside a critical section, or
+ * while the scheduler is not running (e.g. in setup()).
+ *
+ * Its defined as a weak symbol and it can be redefined by the sketch.
+ */
+void yield(void) __attribute__ ((weak));
+void yield(void) {
+	if (taskCanBlock()) {
+		TaskYield();
+	}
+}
+#else
 /**
  * Empty yield() hook.
  *
@@ -29,3 +48,4 @@ static void __empty() {
 	// Empty
 }
 void yield(void) __attribute__ ((weak, alias("__empty")));
+#endif
@@ -8,13 +8,16 @@ unsigned short mainLoopStackSize = CONFIG_MINIMAL_STACK_SIZE;
 TaskHandle loopTaskHandle;
 TaskHandle setupTaskhandle;
 
+// serialEvent()を呼ぶタスクが動いているときは, loop()の後で確認しない.
+static bool serialEventPolling = true;
+
 
 void MainTask(void *parameters)
 {
     for (;;)
     {
         loop();
-        if (serialEventRun) serialEventRun();
+        if (serialEventPolling && serialEventRun) serialEventRun();
     }
 }
 
@@ -25,6 +28,7 @@ void SetupTask(void *parameters)
     TaskSuspendAll();
     {
         setup();
+        if (serialEventTaskStart && serialEventTaskStart()) serialEventPolling = false;
         TaskCreate(MainTask, (signed PortChar *)"Main", mainLoopStackSize, NULL, mainLoopPriority, &loopTaskHandle);
     }
     TaskResumeAll();
@@ -24,6 +24,7 @@ $Id$
 
 #include "wiring_private.h"
 
+#if (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER0)
 // the prescaler is set so that timer0 ticks every 64 clock cycles, and the
 // the overflow handler is called every 256 ticks.
 #define MICROSECONDS_PER_TIMER0_OVERFLOW (clockCyclesToMicroseconds(64 * 256))
@@ -37,15 +38,43 @@ $Id$
 #define FRACT_INC ((MICROSECONDS_PER_TIMER0_OVERFLOW % 1000) >> 3)
 #define FRACT_MAX (1000 >> 3)
 
+// 1tickの時間. tickはTimer0のオーバーフローである.
+#define MICROSECONDS_PER_TICK MICROSECONDS_PER_TIMER0_OVERFLOW
+
+// micros()での1tickの長さと, Timer0のカウントの変換.
+// 64 / clockCyclesPerMicrosecond() が割り切れないF_CPUでは MICROSECONDS_PER_TICK と一致しない.
+#define TICK_PERIOD_IN_MICROS (256UL * (64 / clockCyclesPerMicrosecond()))
+#define TICK_TIMER_COUNT_TO_MICROS(t) ((unsigned long)(t) * (64 / clockCyclesPerMicrosecond()))
+
+#else
+// tickはTimer1またはTimer2のCTCで正確にCONFIG_TICK_RATE_HZで発生するため,
+// 1tickあたりの時間は単純に計算できる.
+#define MICROSECONDS_PER_TICK (1000000UL / (unsigned long)CONFIG_TICK_RATE_HZ)
+
+// タイマーの1カウントあたりのクロック数
+#define TICK_TIMER_CYCLES_PER_COUNT (PORT_TICK_TIMER_PRESCALER)
+
+#define TICK_PERIOD_IN_MICROS MICROSECONDS_PER_TICK
+#define TICK_TIMER_COUNT_TO_MICROS(t) (((unsigned long)(t) * TICK_TIMER_CYCLES_PER_COUNT) / clockCyclesPerMicrosecond())
+#endif
+
+// CONFIG_TICK_SOURCE が PORT_TICK_SOURCE_TIMER0 以外のとき, timer0_overflow_count はtick数である.
 volatile unsigned long timer0_overflow_count = 0;
+// timer0_overflow_count の上位32bit. micros64()で使用する.
+volatile unsigned long timer0_overflow_count_high = 0;
 volatile unsigned long timer0_millis = 0;
+#if (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER0)
 static unsigned char timer0_fract = 0;
+#else
+static unsigned int tick_micros = 0;
+#endif
 
 void ApplicationTickHook(void)
 {
     // copy these to local variables so they can be stored in registers
     // (volatile variables must be read from memory on every access)
     unsigned long m = timer0_millis;
+#if (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER0)
     unsigned char f = timer0_fract;
 
     m += MILLIS_INC;
@@ -57,31 +86,46 @@ void ApplicationTickHook(void)
     }
 
     timer0_fract = f;
+#else
+    // 1tickが1ms未満(CONFIG_TICK_RATE_HZ > 1000)でも, usを積算して1msごとに繰り上げる.
+    unsigned int f = tick_micros + MICROSECONDS_PER_TICK;
+
+    while (f >= 1000)
+    {
+        f -= 1000;
+        m += 1;
+    }
+
+    tick_micros = f;
+#endif
     timer0_millis = m;
-    timer0_overflow_count++;
+    if (++timer0_overflow_count == 0)
+        timer0_overflow_count_high++;
 }
 
 unsigned long millis()
 {
     unsigned long m;
-    uint8_t oldSREG = SREG;
 
     // disable interrupts while we read timer0_millis or we might get an
     // inconsistent value (e.g. in the middle of a write to timer0_millis)
-    cli();
+    // PortEnterCritical()を使うことで, クリティカルセクションプロファイラの対象になる.
+    PortEnterCritical();
     m = timer0_millis;
-    SREG = oldSREG;
+    PortExitCritical();
 
     return m;
 }
 
-unsigned long micros()
+// tick数を読み, tick内の経過時間のタイマーのカウントをcountに入れる.
+// 割り込み禁止中に呼ぶこと.
+static inline unsigned long readTickCount(unsigned int *count)
 {
-    unsigned long m;
-    uint8_t oldSREG = SREG, t;
+    unsigned long m = timer0_overflow_count;
+
+#if (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER0)
+    uint8_t t;
 
-    cli();
-    m = timer0_overflow_count;
 #if defined(TCNT0)
     t = TCNT0;
 #elif defined(TCNT0L)
@@ -98,20 +142,88 @@ unsigned long micros()
     if ((TIFR & _BV(TOV0)) && (t < 255))
         m++;
 #endif
+#else
+    unsigned int t;
+    uint8_t pending;
+
+#if (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER1)
+    t = TCNT1;
+    pending = (TIFR1 & _BV(OCF1A));
+#else
+    t = TCNT2;
+    pending = (TIFR2 & _BV(OCF2A));
+#endif
+
+    // コンペアマッチ後, まだtick割り込みが処理されていない場合.
+    if (pending && (t < PORT_TICK_TIMER_COMPARE))
+        m++;
+#endif
+
+    *count = t;
+    return m;
+}
 
-    SREG = oldSREG;
+unsigned long micros()
+{
+    unsigned long m;
+    unsigned int t;
+
+    PortEnterCritical();
+    m = readTickCount(&t);
+    PortExitCritical();
 
-    return ((m << 8) + t) * (64 / clockCyclesPerMicrosecond());
+    return (m * TICK_PERIOD_IN_MICROS) + TICK_TIMER_COUNT_TO_MICROS(t);
 }
 
+unsigned long long micros64()
+{
+    unsigned long m;
+    unsigned long high;
+    unsigned int t;
 
+    PortEnterCritical();
+    m = readTickCount(&t);
+    high = timer0_overflow_count_high;
+
+    // 保留中のtickを数えたことで桁あふれした場合.
+    if (m < timer0_overflow_count)
+        high++;
+    PortExitCritical();
+
+    return ((((unsigned long long)high << 32) | m) * TICK_PERIOD_IN_MICROS) + TICK_TIMER_COUNT_TO_MICROS(t);
+}
+
+#if (CONFIG_USE_TASK_DELAY_IN_DELAY == 1)
+// 1回のTaskDelay()で待つ時間の上限(ms). ms * 1000 が桁あふれしないようにする.
+#define DELAY_MAX_BLOCK_MILLIS 4000000UL
+#endif
 
 void delay(unsigned long ms)
 {
     uint32_t start = micros();
+#if (CONFIG_USE_TASK_DELAY_IN_DELAY == 1)
+    unsigned long ticks;
+#endif
 
     while (ms > 0) {
+#if (CONFIG_USE_TASK_DELAY_IN_DELAY == 1)
+        // TaskDelay(n)は次のtickまでの端数を含めて(n - 1)tickから ntick待つ.
+        // 待ちすぎないように, 残り時間に収まるtick数より1少なく待ち,
+        // 1tickに満たない残りは従来通りmicros()で待つ.
+        ticks = ((ms > DELAY_MAX_BLOCK_MILLIS) ? DELAY_MAX_BLOCK_MILLIS : ms) * 1000UL / MICROSECONDS_PER_TICK;
+        if (ticks > (unsigned long)(PORT_MAX_DELAY - 1)) {
+            ticks = (unsigned long)(PORT_MAX_DELAY - 1);
+        }
+
+        if (ticks > 1 && taskCanBlock()) {
+            TaskDelay((PortTickType)(ticks - 1));
+        }
+        else {
+            yield();
+        }
+#else
         yield();
+#endif
         while (ms > 0 && (micros() - start) >= 1000) {
             ms--;
             start += 1000;
@@ -119,6 +231,59 @@ void delay(unsigned long ms)
     }
 }
 
+// TaskDelayMicros()で, delayMicroseconds()で待ち切る残り時間(us)
+#define DELAY_MICROS_SPIN_FINISH 16
+
+// 1tick以上の部分はタスクをブロックして待ち, 1tickに満たない残りは待ち続ける.
+// TaskDelay(n)はn個目のtickの境界で起きるため, 境界が待ち終わる時刻を超えない分だけブロックする.
+// ブロックできないとき(setup()の中や割り込み禁止中)は, すべて待ち続ける.
+void TaskDelayMicros(unsigned long us)
+{
+    unsigned long start;
+    unsigned long m;
+    unsigned long elapsed, remaining, untilNextTick, ticks;
+    unsigned int t;
+
+    PortEnterCritical();
+    m = readTickCount(&t);
+    PortExitCritical();
+    start = (m * TICK_PERIOD_IN_MICROS) + TICK_TIMER_COUNT_TO_MICROS(t);
+
+    for (;;) {
+        elapsed = (m * TICK_PERIOD_IN_MICROS) + TICK_TIMER_COUNT_TO_MICROS(t) - start;
+        if (elapsed >= us)
+            return;
+
+        remaining = us - elapsed;
+        untilNextTick = TICK_PERIOD_IN_MICROS - TICK_TIMER_COUNT_TO_MICROS(t);
+        if (remaining < untilNextTick || !taskCanBlock())
+            break;
+
+        ticks = 1 + (remaining - untilNextTick) / TICK_PERIOD_IN_MICROS;
+        if (ticks > (unsigned long)(PORT_MAX_DELAY - 1))
+            ticks = (unsigned long)(PORT_MAX_DELAY - 1);
+        TaskDelay((PortTickType)ticks);
+
+        PortEnterCritical();
+        m = readTickCount(&t);
+        PortExitCritical();
+    }
+
+    // 1tickに満たない残り. micros()の呼び出しにかかる時間より短くなったら,
+    // サイクル数で調整されたdelayMicroseconds()で待ち切る.
+    for (;;) {
+        elapsed = micros() - start;
+        if (elapsed >= us)
+            return;
+
+        remaining = us - elapsed;
+        if (remaining <= DELAY_MICROS_SPIN_FINISH) {
+            delayMicroseconds((unsigned int)remaining);
+            return;
+        }
+    }
+}
+
 /* Delay for the given number of microseconds.  Assumes a 8 or 16 MHz clock. */
 void delayMicroseconds(unsigned int us)
 {
@@ -275,6 +440,10 @@ void init()
 
     // enable a2d conversions
     sbi(ADCSRA, ADEN);
+
+#if (CONFIG_USE_ADC_SERVICE == 1)
+    AdcServiceInit();
+#endif
 #endif
 
     // the bootloader connects pins 0 and 1 to the USART; disconnect them
@@ -35,10 +35,9 @@ void analogReference(uint8_t mode)
 	analog_reference = mode;
 }
 
-int analogRead(uint8_t pin)
+// ピン番号(A0など)またはチャンネル番号を, ADCのチャンネル番号に変換する.
+uint8_t analogPinToAdcChannel(uint8_t pin)
 {
-	uint8_t low, high;
-
 #if defined(analogPinToChannel)
 #if defined(__AVR_ATmega32U4__)
 	if (pin >= 18) pin -= 18; // allow for channel or pin numbers
@@ -54,10 +53,16 @@ int analogRead(uint8_t pin)
 	if (pin >= 14) pin -= 14; // allow for channel or pin numbers
 #endif
 
+	return pin;
+}
+
+// ADCのチャンネルを選択する. 割り込み関数からも呼ばれる.
+void analogSelectChannel(uint8_t channel)
+{
 #if defined(ADCSRB) && defined(MUX5)
 	// the MUX5 bit of ADCSRB selects whether we're reading from channels
 	// 0 to 7 (MUX5 low) or 8 to 15 (MUX5 high).
-	ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((pin >> 3) & 0x01) << MUX5);
+	ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((channel >> 3) & 0x01) << MUX5);
 #endif
   
 	// set the analog reference (high two bits of ADMUX) and select the
@@ -65,11 +70,29 @@ int analogRead(uint8_t pin)
 	// to 0 (the default).
 #if defined(ADMUX)
 #if defined(__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) || defined(__AVR_ATtiny85__)
-	ADMUX = (analog_reference << 4) | (pin & 0x07);
+	ADMUX = (analog_reference << 4) | (channel & 0x07);
 #else
-	ADMUX = (analog_reference << 6) | (pin & 0x07);
+	ADMUX = (analog_reference << 6) | (channel & 0x07);
+#endif
 #endif
+}
+
+int analogRead(uint8_t pin)
+{
+#if (CONFIG_USE_ADC_SERVICE == 1) && defined(ADCSRA) && defined(ADCL)
+	// 変換の完了までタスクをブロックする.
+	return AdcRead(pin);
+#else
+	return analogReadChannelPolling(analogPinToAdcChannel(pin));
 #endif
+}
+
+// 変換が終わるまでADSCを見て待つ.
+int analogReadChannelPolling(uint8_t channel)
+{
+	uint8_t low, high;
+
+	analogSelectChannel(channel);
 
 	// without a delay, we seem to read from the wrong channel
 	//delay(1);
@@ -119,7 +142,19 @@ void analogWrite(uint8_t pin, int val)
 	}
 	else
 	{
-		switch(digitalPinToTimer(pin))
+		uint8_t timer = digitalPinToTimer(pin);
+
+		// The timer used for the kernel tick (CONFIG_TICK_SOURCE) runs in CTC
+		// mode, so its pins fall through to the digital output below.
+		// So do the pins of a timer acquired through TimerAcquire() (tone(),
+		// pulse measurement, ADC scan), as writing their compare registers
+		// would disturb the current owner.
+		if (timer != NOT_ON_TIMER && !TimerPwmAvailable(TimerOfPin(pin)))
+		{
+			timer = NOT_ON_TIMER;
+		}
+
+		switch(timer)
 		{
 			// XXX fix needed for atmega8
 			#if defined(TCCR0) && defined(COM00) && !defined(__AVR_ATmega8__)
@@ -146,7 +181,7 @@ void analogWrite(uint8_t pin, int val)
 				break;
 			#endif
 
-			#if defined(TCCR1A) && defined(COM1A1)
+			#if defined(TCCR1A) && defined(COM1A1) && (CONFIG_TICK_SOURCE != PORT_TICK_SOURCE_TIMER1)
 			case TIMER1A:
 				// connect pwm to pin on timer 1, channel A
 				sbi(TCCR1A, COM1A1);
@@ -154,7 +189,7 @@ void analogWrite(uint8_t pin, int val)
 				break;
 			#endif
 
-			#if defined(TCCR1A) && defined(COM1B1)
+			#if defined(TCCR1A) && defined(COM1B1) && (CONFIG_TICK_SOURCE != PORT_TICK_SOURCE_TIMER1)
 			case TIMER1B:
 				// connect pwm to pin on timer 1, channel B
 				sbi(TCCR1A, COM1B1);
@@ -162,7 +197,7 @@ void analogWrite(uint8_t pin, int val)
 				break;
 			#endif
 
-			#if defined(TCCR1A) && defined(COM1C1)
+			#if defined(TCCR1A) && defined(COM1C1) && (CONFIG_TICK_SOURCE != PORT_TICK_SOURCE_TIMER1)
 			case TIMER1C:
 				// connect pwm to pin on timer 1, channel B
 				sbi(TCCR1A, COM1C1);
@@ -170,7 +205,7 @@ void analogWrite(uint8_t pin, int val)
 				break;
 			#endif
 
-			#if defined(TCCR2) && defined(COM21)
+			#if defined(TCCR2) && defined(COM21) && (CONFIG_TICK_SOURCE != PORT_TICK_SOURCE_TIMER2)
 			case TIMER2:
 				// connect pwm to pin on timer 2
 				sbi(TCCR2, COM21);
@@ -178,7 +213,7 @@ void analogWrite(uint8_t pin, int val)
 				break;
 			#endif
 
-			#if defined(TCCR2A) && defined(COM2A1)
+			#if defined(TCCR2A) && defined(COM2A1) && (CONFIG_TICK_SOURCE != PORT_TICK_SOURCE_TIMER2)
 			case TIMER2A:
 				// connect pwm to pin on timer 2, channel A
 				sbi(TCCR2A, COM2A1);
@@ -186,7 +221,7 @@ void analogWrite(uint8_t pin, int val)
 				break;
 			#endif
 
-			#if defined(TCCR2A) && defined(COM2B1)
+			#if defined(TCCR2A) && defined(COM2B1) && (CONFIG_TICK_SOURCE != PORT_TICK_SOURCE_TIMER2)
 			case TIMER2B:
 				// connect pwm to pin on timer 2, channel B
 				sbi(TCCR2A, COM2B1);
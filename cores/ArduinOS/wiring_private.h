@@ -65,6 +65,18 @@ uint32_t countPulseASM(volatile uint8_t *port, uint8_t bit, uint8_t stateMask, u
 
 typedef void (*voidFuncPtr)(void);
 
+// タスクから呼ばれ, ブロックしてもよい状態か.
+// 割り込み関数, クリティカルセクションの中と, スケジューラが停止中(setup()の中)はブロックできない.
+static inline int taskCanBlock(void)
+{
+  return bit_is_set(SREG, SREG_I) && (TaskGetSchedulerState() == TASK_SCHEDULER_RUNNING);
+}
+
+// ADC. wiring_analog.c
+uint8_t analogPinToAdcChannel(uint8_t pin);
+void analogSelectChannel(uint8_t channel);
+int analogReadChannelPolling(uint8_t channel);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
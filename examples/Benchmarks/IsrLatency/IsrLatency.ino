@@ -0,0 +1,119 @@
+/*
+ * ISR latency
+ *
+ * 割り込みが起きてから, 割り込みで起床したタスクが動き出すまでのCPUサイクル数を測定します.
+ *
+ * INT0(D2)はISR_WITH_YIELD()で宣言し, 割り込みの終わりで待っているタスクへ直接切り替えます.
+ * INT1(D3)は通常のISR()で宣言し, 次のtickでタスクが切り替わるのを待ちます.
+ * 両方のピンを出力にして自分で割り込みを発生させるため, 配線は不要です.
+ * WakeTaskがセマフォを待っている間に, 優先度の低いBusyTaskがピンを立ち上げます.
+ *
+ * Timer1を分周1のノーマルモードで動かし, TCNT1をサイクルカウンタとして使用します.
+ * そのため, CONFIG_TICK_SOURCE に PORT_TICK_SOURCE_TIMER1 を使用しているときは測定できません.
+ * 分周1のTimer1は約4ms(16Mhz)で一周するため, tickを待つ測定ではそれ以下の値になります.
+ *
+ * 出力形式:
+ *  LATENCY <name> <min cycles> <max cycles> <samples>
+ */
+
+#if (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER1)
+  #error IsrLatency uses Timer1 as the cycle counter
+#endif
+
+#define LATENCY_SAMPLES 32
+
+DeclareTaskLoop(WakeTask);
+DeclareTaskLoop(BusyTask);
+
+SemaphoreHandle yieldSemaphore;
+SemaphoreHandle tickSemaphore;
+
+volatile unsigned short triggerTime;
+
+// BusyTaskに立ち上げてもらうピン. 0のときは何もしない.
+volatile unsigned char triggerPin = 0;
+
+ISR_WITH_YIELD(INT0_vect) {
+  signed PortBaseType higherPriorityTaskWoken = PD_FALSE;
+
+  SemaphoreGiveFromISR(yieldSemaphore, &higherPriorityTaskWoken);
+  YieldFromISR(higherPriorityTaskWoken);
+}
+
+ISR(INT1_vect) {
+  SemaphoreGiveFromISR(tickSemaphore, NULL);
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  CreateBinarySemaphore(yieldSemaphore);
+  CreateBinarySemaphore(tickSemaphore);
+  SemaphoreTake(yieldSemaphore, 0);
+  SemaphoreTake(tickSemaphore, 0);
+
+  // D2, D3を出力にし, 立ち上がりで割り込みを発生させる.
+  DDRD |= _BV(PD2) | _BV(PD3);
+  PORTD &= ~(_BV(PD2) | _BV(PD3));
+  EICRA = _BV(ISC01) | _BV(ISC00) | _BV(ISC11) | _BV(ISC10);
+  EIFR = _BV(INTF0) | _BV(INTF1);
+  EIMSK = _BV(INT0) | _BV(INT1);
+
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);
+
+  CreateTaskLoopWithStackSize(WakeTask, HIGH_PRIORITY, 160);
+
+  // 割り込まれる側のタスク. 常に実行可能な状態にしておく.
+  CreateTaskLoop(BusyTask, NORMAL_PRIORITY);
+}
+
+void loop() {
+  TaskSuspendSelf();
+}
+
+void Measure(SemaphoreHandle semaphore, unsigned char pin, const __FlashStringHelper *name) {
+  unsigned short minCycles = 0xffff;
+  unsigned short maxCycles = 0;
+  unsigned short cycles;
+
+  for (unsigned char i = 0; i < LATENCY_SAMPLES; i++) {
+    triggerPin = _BV(pin);
+    SemaphoreTake(semaphore, PORT_MAX_DELAY);
+    cycles = TCNT1 - triggerTime;
+    PORTD &= ~_BV(pin);
+
+    if (cycles < minCycles) minCycles = cycles;
+    if (cycles > maxCycles) maxCycles = cycles;
+  }
+
+  Serial.print(F("LATENCY "));
+  Serial.print(name);
+  Serial.print(' ');
+  Serial.print(minCycles);
+  Serial.print(' ');
+  Serial.print(maxCycles);
+  Serial.print(' ');
+  Serial.println(LATENCY_SAMPLES);
+  Serial.flush();
+}
+
+TaskLoop(WakeTask) {
+  Measure(yieldSemaphore, PD2, F("isr_with_yield"));
+  Measure(tickSemaphore, PD3, F("isr_wait_tick"));
+  TaskDelay(1000);
+}
+
+TaskLoop(BusyTask) {
+  unsigned char pin = triggerPin;
+
+  if (pin != 0) {
+    triggerPin = 0;
+
+    // 時刻を記録してから割り込みが起きるようにする.
+    EnterCritical();
+    triggerTime = TCNT1;
+    PORTD |= pin;
+    ExitCritical();
+  }
+}
@@ -0,0 +1,250 @@
+/*
+ * Kernel benchmark
+ *
+ * カーネルの主な操作にかかるCPUサイクル数を測定し, シリアルに出力します.
+ * extras/benchmark/run_benchmarks.py からsimavr上で実行することを想定していますが,
+ * 実機でもシリアルモニタで結果を確認できます.
+ *
+ * Timer1を分周1のノーマルモードで動かし, TCNT1をサイクルカウンタとして使用します.
+ * そのため, CONFIG_TICK_SOURCE に PORT_TICK_SOURCE_TIMER1 を使用しているときは測定できません.
+ *
+ * 出力形式(1行1結果, 値はTCNT1の読み取りにかかるサイクル数を差し引いたもの):
+ *  BENCH_CONFIG <name> <value>
+ *  BENCH <name> <min cycles> <max cycles> <samples>
+ *  BENCH_DONE
+ *
+ * BENCH_DONEの後は割り込みを禁止してスリープします. simavrはここで終了します.
+ */
+
+#include <avr/sleep.h>
+
+#if (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER1)
+  #error KernelBenchmark uses Timer1 as the cycle counter
+#endif
+
+#define BENCH_SAMPLES 32
+
+DeclareTaskLoop(BenchTask);
+DeclareTaskLoop(PartnerTask);
+
+QueueHandle benchQueue;
+SemaphoreHandle benchSemaphore;
+SemaphoreHandle benchMutex;
+
+struct BenchResult {
+  unsigned short minCycles;
+  unsigned short maxCycles;
+};
+
+unsigned short overhead;
+
+void setup() {
+  Serial.begin(115200);
+
+  benchQueue = QueueCreate(1, sizeof(unsigned char));
+  CreateBinarySemaphore(benchSemaphore);
+  CreateMutex(benchMutex);
+
+  CreateTaskLoopWithStackSize(BenchTask, HIGH_PRIORITY, 160);
+
+  // PartnerTaskはyieldの測定中だけ動かす.
+  CreateTaskLoop(PartnerTask, HIGH_PRIORITY);
+  TaskSuspend(PartnerTask);
+}
+
+void loop() {
+  TaskSuspendSelf();
+}
+
+void StartCycleCounter() {
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);
+  TCNT1 = 0;
+}
+
+void ResetResult(BenchResult &result) {
+  result.minCycles = 0xffff;
+  result.maxCycles = 0;
+}
+
+void Record(BenchResult &result, unsigned short cycles) {
+  cycles -= overhead;
+  if (cycles < result.minCycles) result.minCycles = cycles;
+  if (cycles > result.maxCycles) result.maxCycles = cycles;
+}
+
+void Report(const __FlashStringHelper *name, const BenchResult &result) {
+  Serial.print(F("BENCH "));
+  Serial.print(name);
+  Serial.print(' ');
+  Serial.print(result.minCycles);
+  Serial.print(' ');
+  Serial.print(result.maxCycles);
+  Serial.print(' ');
+  Serial.println(BENCH_SAMPLES);
+
+  // 送信割り込みが次の測定に入らないようにする.
+  Serial.flush();
+}
+
+void ReportConfig(const __FlashStringHelper *name, unsigned long value) {
+  Serial.print(F("BENCH_CONFIG "));
+  Serial.print(name);
+  Serial.print(' ');
+  Serial.println(value);
+}
+
+// TCNT1を2回読むだけのサイクル数
+void MeasureOverhead() {
+  BenchResult result;
+  unsigned short start, cycles;
+
+  overhead = 0;
+  ResetResult(result);
+  for (unsigned char i = 0; i < BENCH_SAMPLES; i++) {
+    start = TCNT1;
+    cycles = TCNT1 - start;
+    Record(result, cycles);
+  }
+  overhead = result.minCycles;
+}
+
+// yieldしてから戻るまで. 2回のコンテキストスイッチとPartnerTaskのループ1回分.
+void MeasureYield() {
+  BenchResult result;
+  unsigned short start;
+
+  TaskResume(PartnerTask);
+  ResetResult(result);
+  for (unsigned char i = 0; i < BENCH_SAMPLES; i++) {
+    start = TCNT1;
+    TaskYield();
+    Record(result, TCNT1 - start);
+  }
+  TaskSuspend(PartnerTask);
+  Report(F("yield_roundtrip"), result);
+}
+
+void MeasureQueue() {
+  BenchResult send, receive;
+  unsigned short start;
+  unsigned char item = 0;
+
+  ResetResult(send);
+  ResetResult(receive);
+  for (unsigned char i = 0; i < BENCH_SAMPLES; i++) {
+    start = TCNT1;
+    QueueSend(benchQueue, &item, 0);
+    Record(send, TCNT1 - start);
+
+    start = TCNT1;
+    QueueReceive(benchQueue, &item, 0);
+    Record(receive, TCNT1 - start);
+  }
+  Report(F("queue_send"), send);
+  Report(F("queue_receive"), receive);
+}
+
+void MeasureSemaphore(SemaphoreHandle semaphore, const __FlashStringHelper *name) {
+  BenchResult result;
+  unsigned short start;
+
+  ResetResult(result);
+  for (unsigned char i = 0; i < BENCH_SAMPLES; i++) {
+    start = TCNT1;
+    SemaphoreTake(semaphore, 0);
+    SemaphoreGive(semaphore);
+    Record(result, TCNT1 - start);
+  }
+  Report(name, result);
+}
+
+void MeasureMalloc() {
+  BenchResult result;
+  unsigned short start;
+  void *block;
+
+  ResetResult(result);
+  for (unsigned char i = 0; i < BENCH_SAMPLES; i++) {
+    start = TCNT1;
+    block = PortMalloc(16);
+    PortFree(block);
+    Record(result, TCNT1 - start);
+  }
+  Report(F("malloc_free_16"), result);
+}
+
+void MeasureCritical() {
+  BenchResult result;
+  unsigned short start;
+
+  ResetResult(result);
+  for (unsigned char i = 0; i < BENCH_SAMPLES; i++) {
+    start = TCNT1;
+    EnterCritical();
+    ExitCritical();
+    Record(result, TCNT1 - start);
+  }
+  Report(F("critical_section"), result);
+}
+
+// TCNT1を読み続け, 読み取り間隔が延びた分をtick割り込みのコストとする.
+// 他のタスクはすべて停止しているため, tickでコンテキストスイッチは起こらない.
+void MeasureTick() {
+  BenchResult result;
+  unsigned short previous, now, gap;
+  unsigned short minGap = 0xffff;
+  PortTickType lastTick;
+  unsigned char ticks = 0;
+
+  ResetResult(result);
+  lastTick = TaskGetTickCount();
+  previous = TCNT1;
+  while (ticks < BENCH_SAMPLES) {
+    now = TCNT1;
+    gap = now - previous;
+    previous = now;
+
+    if (gap < minGap) minGap = gap;
+    if (TaskGetTickCount() != lastTick) {
+      lastTick = TaskGetTickCount();
+      if (gap > result.maxCycles) result.maxCycles = gap;
+      if (gap < result.minCycles) result.minCycles = gap;
+      ticks++;
+    }
+  }
+  result.minCycles -= minGap;
+  result.maxCycles -= minGap;
+  Report(F("tick_isr"), result);
+}
+
+TaskLoop(BenchTask) {
+  StartCycleCounter();
+
+  ReportConfig(F("f_cpu"), F_CPU);
+  ReportConfig(F("tick_rate_hz"), CONFIG_TICK_RATE_HZ);
+  ReportConfig(F("tick_source"), CONFIG_TICK_SOURCE);
+  ReportConfig(F("free_heap"), PortGetFreeHeapSize());
+  Serial.flush();
+
+  MeasureOverhead();
+  MeasureYield();
+  MeasureQueue();
+  MeasureSemaphore(benchSemaphore, F("semaphore_take_give"));
+  MeasureSemaphore(benchMutex, F("mutex_take_give"));
+  MeasureMalloc();
+  MeasureCritical();
+  MeasureTick();
+
+  Serial.println(F("BENCH_DONE"));
+  Serial.flush();
+
+  cli();
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  sleep_cpu();
+}
+
+TaskLoop(PartnerTask) {
+  TaskYield();
+}
@@ -0,0 +1,143 @@
+/*
+ * Print format
+ *
+ * Print::print()で数値を1つ文字列にするのにかかるCPUサイクル数を測定します.
+ *
+ * 出力先は書き込まれた文字を捨てるNullPrintのため, シリアルの送信時間は含まれません.
+ * beforeは変更前のPrintの変換(1桁ごとの32bit除算, 小数部の1桁ごとの浮動小数点の乗算)を
+ * LegacyPrintに写したもの, afterは現在のPrintの変換です.
+ *
+ * Timer1を分周1のノーマルモードで動かし, TCNT1をサイクルカウンタとして使用します.
+ * そのため, CONFIG_TICK_SOURCE に PORT_TICK_SOURCE_TIMER1 を使用しているときは測定できません.
+ * 測定中は割り込みを禁止します.
+ *
+ * 出力形式:
+ *  PRINT <name> <before cycles> <after cycles>
+ */
+
+#if (CONFIG_TICK_SOURCE == PORT_TICK_SOURCE_TIMER1)
+  #error PrintFormat uses Timer1 as the cycle counter
+#endif
+
+class NullPrint : public Print {
+public:
+  virtual size_t write(uint8_t) { return 1; }
+  virtual size_t write(const uint8_t *, size_t size) { return size; }
+};
+
+// 変更前のPrint::printNumber(), Print::printFloat()
+class LegacyPrint : public NullPrint {
+public:
+  size_t printNumber(unsigned long n, uint8_t base) {
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+
+    *str = '\0';
+
+    if (base < 2) base = 10;
+
+    do {
+      char c = n % base;
+      n /= base;
+
+      *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while(n);
+
+    return Print::write(str);
+  }
+
+  size_t printFloat(double number, uint8_t digits) {
+    size_t n = 0;
+
+    if (number < 0.0) {
+      n += Print::print('-');
+      number = -number;
+    }
+
+    double rounding = 0.5;
+    for (uint8_t i = 0; i < digits; ++i)
+      rounding /= 10.0;
+
+    number += rounding;
+
+    unsigned long int_part = (unsigned long)number;
+    double remainder = number - (double)int_part;
+    n += printNumber(int_part, 10);
+
+    if (digits > 0) {
+      n += Print::print(".");
+    }
+
+    while (digits-- > 0) {
+      remainder *= 10.0;
+      unsigned int toPrint = (unsigned int)(remainder);
+      n += printNumber(toPrint, 10);
+      remainder -= toPrint;
+    }
+
+    return n;
+  }
+};
+
+NullPrint after;
+LegacyPrint before;
+
+void Report(const __FlashStringHelper *name, unsigned short beforeCycles, unsigned short afterCycles) {
+  Serial.print(F("PRINT "));
+  Serial.print(name);
+  Serial.print(' ');
+  Serial.print(beforeCycles);
+  Serial.print(' ');
+  Serial.println(afterCycles);
+  Serial.flush();
+}
+
+void MeasureNumber(const __FlashStringHelper *name, unsigned long value, uint8_t base) {
+  unsigned short start, beforeCycles, afterCycles;
+
+  EnterCritical();
+  start = TCNT1;
+  before.printNumber(value, base);
+  beforeCycles = TCNT1 - start;
+
+  start = TCNT1;
+  after.print(value, base);
+  afterCycles = TCNT1 - start;
+  ExitCritical();
+
+  Report(name, beforeCycles, afterCycles);
+}
+
+void MeasureFloat(const __FlashStringHelper *name, double value, uint8_t digits) {
+  unsigned short start, beforeCycles, afterCycles;
+
+  EnterCritical();
+  start = TCNT1;
+  before.printFloat(value, digits);
+  beforeCycles = TCNT1 - start;
+
+  start = TCNT1;
+  after.print(value, digits);
+  afterCycles = TCNT1 - start;
+  ExitCritical();
+
+  Report(name, beforeCycles, afterCycles);
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);
+}
+
+void loop() {
+  MeasureNumber(F("dec_u8"), 200, DEC);
+  MeasureNumber(F("dec_u16"), 54321, DEC);
+  MeasureNumber(F("dec_u32"), 4000000000UL, DEC);
+  MeasureNumber(F("hex_u32"), 0xDEADBEEFUL, HEX);
+  MeasureNumber(F("bin_u16"), 0xA5A5, BIN);
+  MeasureFloat(F("float_2"), 1234.56, 2);
+  MeasureFloat(F("float_6"), 3.141593, 6);
+  TaskDelay(1000);
+}
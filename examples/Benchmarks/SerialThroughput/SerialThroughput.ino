@@ -0,0 +1,126 @@
+/*
+ * Serial throughput
+ *
+ * Serialへの送信速度(bytes/s)と, 送信中にCPUを使用した割合(%)を測定します.
+ *
+ * per_byteは1byteずつwrite(uint8_t)を呼び, bulkはwrite(const uint8_t *, size_t)で
+ * まとめて送信バッファへ書き込みます. buffered_printはBufferedPrintを経由してprint()します.
+ *
+ * 測定はNORMAL_PRIORITYのMeasureTaskで行います. CPUの使用率は, LOW_PRIORITYのIdleCounterTaskが
+ * 数えた回数を, 送信していないときの回数と比べて求めます. IdleCounterTaskはMeasureTaskが
+ * ブロックしている間だけ動くため, 送信で使用されなかった時間だけを数えます.
+ * 同じLOW_PRIORITYで動くものがIdleCounterTaskとアイドルタスクだけになるよう, loop()は停止させます.
+ * 送信バッファの空きを待つ間にタスクがブロックするよう, CONFIG_USE_TASK_BLOCKING_SERIAL は1にしてください.
+ * 0のときは空きを待つ間も回り続けるため, 使用率は常に100%近くになります.
+ *
+ * 各ボーレートで測定した後, 115200bpsに戻して結果を出力します.
+ *
+ * 出力形式:
+ *  SERIAL <baud> <name> <bytes/s> <cpu %>
+ */
+
+#define MEASURE_MILLIS 1000
+#define BLOCK_SIZE 32
+
+DeclareTaskLoop(MeasureTask);
+DeclareTaskLoop(IdleCounterTask);
+
+volatile unsigned long idleCount;
+
+const unsigned long bauds[] = {115200, 1000000};
+
+struct Result {
+  unsigned long bytesPerSecond;
+  unsigned char cpuPercent;
+};
+
+uint8_t block[BLOCK_SIZE];
+
+void setup() {
+  for (uint8_t i = 0; i < BLOCK_SIZE; i++) {
+    block[i] = (i == BLOCK_SIZE - 1) ? '\n' : 'A' + (i % 26);
+  }
+
+  // 測定結果を持つため, スタックを多めに確保する.
+  CreateTaskLoopWithStackSize(MeasureTask, NORMAL_PRIORITY, 192);
+  CreateTaskLoop(IdleCounterTask, LOW_PRIORITY);
+}
+
+void loop() {
+  TaskSuspendSelf();
+}
+
+TaskLoop(IdleCounterTask) {
+  idleCount++;
+}
+
+void SendPerByte() {
+  for (uint8_t i = 0; i < BLOCK_SIZE; i++) {
+    Serial.write(block[i]);
+  }
+}
+
+void SendBulk() {
+  Serial.write(block, BLOCK_SIZE);
+}
+
+void SendBufferedPrint() {
+  BufferedPrint<BLOCK_SIZE> out(Serial);
+
+  // 31文字と改行
+  out.print(F("ABCDEFGHIJKLMNOPQRSTUVWXYZABCDE"));
+  out.write('\n');
+}
+
+unsigned long CountIdle() {
+  Serial.flush();
+  idleCount = 0;
+  TaskDelayMillis(MEASURE_MILLIS);
+  return idleCount;
+}
+
+Result Measure(void (*send)(), unsigned long baseline) {
+  Result result;
+  unsigned long bytes = 0;
+  unsigned long start;
+
+  Serial.flush();
+  idleCount = 0;
+  start = millis();
+  while (millis() - start < MEASURE_MILLIS) {
+    send();
+    bytes += BLOCK_SIZE;
+  }
+  unsigned long idle = idleCount;
+  unsigned long elapsed = millis() - start;
+
+  result.bytesPerSecond = bytes * 1000 / elapsed;
+  result.cpuPercent = (idle >= baseline) ? 0 : 100 - (unsigned char)(idle * 100 / baseline);
+  return result;
+}
+
+TaskLoop(MeasureTask) {
+  Result results[sizeof(bauds) / sizeof(bauds[0])][3];
+
+  for (uint8_t b = 0; b < sizeof(bauds) / sizeof(bauds[0]); b++) {
+    Serial.begin(bauds[b]);
+    unsigned long baseline = CountIdle();
+    results[b][0] = Measure(SendPerByte, baseline);
+    results[b][1] = Measure(SendBulk, baseline);
+    results[b][2] = Measure(SendBufferedPrint, baseline);
+    Serial.flush();
+  }
+
+  Serial.begin(115200);
+  Serial.println();
+  for (uint8_t b = 0; b < sizeof(bauds) / sizeof(bauds[0]); b++) {
+    for (uint8_t i = 0; i < 3; i++) {
+      static const char *const names[] = {"per_byte", "bulk", "buffered_print"};
+      Serial.printf(F("SERIAL %lu %s %lu %u\n"), bauds[b], names[i],
+                    results[b][i].bytesPerSecond, results[b][i].cpuPercent);
+    }
+  }
+  Serial.flush();
+
+  TaskDelayMillis(5000);
+}
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+# ArduinOS kernel benchmark runner
+#
+# examples/Benchmarks/KernelBenchmark をビルドしてsimavr上で実行し,
+# 結果をJSON形式のレポートとして保存します.
+#
+# 必要なもの:
+#  arduino-cli (ArduinOSのコアがインストールされていること. --elfを使う場合は不要)
+#  simavr
+#
+# Example usage:
+#
+#  python3 extras/benchmark/run_benchmarks.py --mcu atmega328p --mcu atmega2560
+#  python3 extras/benchmark/run_benchmarks.py --compare bench-atmega328p-old.json
+#
+# レポートの形式:
+#
+#  {
+#    "mcu": "atmega328p",
+#    "commit": "<git commit>",
+#    "dirty": false,
+#    "config": {"f_cpu": 16000000, "tick_rate_hz": 1000, ...},
+#    "results": {"yield_roundtrip": {"min": 0, "max": 0, "samples": 32}, ...}
+#  }
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+REPO_ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', '..'))
+SKETCH = os.path.join(REPO_ROOT, 'examples', 'Benchmarks', 'KernelBenchmark')
+
+# boards.txt のボード名
+BOARDS = {
+    'atmega328p': 'unoArduinOS',
+    'atmega2560': 'megaArduinOS',
+}
+
+ANSI_ESCAPE = re.compile(r'\x1b\[[0-9;]*m')
+BENCH_LINE = re.compile(r'BENCH(_CONFIG|_DONE)?\b.*')
+
+
+def git_revision():
+    try:
+        commit = subprocess.check_output(
+            ['git', 'rev-parse', 'HEAD'], cwd=REPO_ROOT, text=True).strip()
+        dirty = subprocess.call(
+            ['git', 'diff', '--quiet', 'HEAD', '--', 'cores'], cwd=REPO_ROOT) != 0
+    except (OSError, subprocess.CalledProcessError):
+        return None, False
+    return commit, dirty
+
+
+def build(mcu, fqbn_prefix, build_dir):
+    fqbn = '%s:%s' % (fqbn_prefix, BOARDS[mcu])
+    subprocess.check_call(['arduino-cli', 'compile', '--fqbn', fqbn,
+                           '--build-path', build_dir, SKETCH])
+    return os.path.join(build_dir, 'KernelBenchmark.ino.elf')
+
+
+def run(simavr, mcu, f_cpu, elf, timeout):
+    # BENCH_DONEの後, スケッチは割り込み禁止でスリープし, simavrが終了する.
+    process = subprocess.run([simavr, '-m', mcu, '-f', str(f_cpu), elf],
+                             stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                             text=True, errors='replace', timeout=timeout)
+    return ANSI_ESCAPE.sub('', process.stdout)
+
+
+def parse(output):
+    config = {}
+    results = {}
+    done = False
+
+    for line in output.splitlines():
+        # simavrはUARTの出力に接頭辞を付けることがあるため, BENCHの位置を探す.
+        match = BENCH_LINE.search(line)
+        if match is None:
+            continue
+        fields = match.group(0).split()
+
+        if fields[0] == 'BENCH_CONFIG' and len(fields) == 3:
+            config[fields[1]] = int(fields[2])
+        elif fields[0] == 'BENCH' and len(fields) == 5:
+            results[fields[1]] = {
+                'min': int(fields[2]),
+                'max': int(fields[3]),
+                'samples': int(fields[4]),
+            }
+        elif fields[0] == 'BENCH_DONE':
+            done = True
+
+    return config, results, done
+
+
+def compare(report, baseline):
+    print('%-24s %10s %10s %8s' % ('benchmark', 'baseline', 'current', 'delta'))
+    for name, result in sorted(report['results'].items()):
+        base = baseline.get('results', {}).get(name)
+        if base is None:
+            print('%-24s %10s %10d %8s' % (name, '-', result['min'], '-'))
+            continue
+        print('%-24s %10d %10d %+8d' % (
+            name, base['min'], result['min'], result['min'] - base['min']))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Run the ArduinOS kernel benchmarks under simavr.')
+    parser.add_argument('--mcu', action='append', choices=sorted(BOARDS),
+                        help='MCU to benchmark (default: atmega328p)')
+    parser.add_argument('--elf', help='use a prebuilt KernelBenchmark elf instead of building')
+    parser.add_argument('--fqbn-prefix', default='ArduinOS:avr',
+                        help='vendor:architecture the core is installed as (default: ArduinOS:avr)')
+    parser.add_argument('--f-cpu', type=int, default=16000000)
+    parser.add_argument('--simavr', default='simavr')
+    parser.add_argument('--timeout', type=float, default=60.0)
+    parser.add_argument('--output-dir', default='.')
+    parser.add_argument('--compare', help='baseline report to compare the results with')
+    args = parser.parse_args()
+
+    mcus = args.mcu or ['atmega328p']
+    if args.elf and len(mcus) != 1:
+        parser.error('--elf can only be used with a single --mcu')
+
+    commit, dirty = git_revision()
+    failed = False
+
+    for mcu in mcus:
+        with tempfile.TemporaryDirectory() as build_dir:
+            elf = args.elf or build(mcu, args.fqbn_prefix, build_dir)
+            try:
+                output = run(args.simavr, mcu, args.f_cpu, elf, args.timeout)
+            except subprocess.TimeoutExpired:
+                output = ''
+
+        config, results, done = parse(output)
+        if not done:
+            sys.stderr.write('%s: benchmark did not finish\n%s' % (mcu, output))
+            failed = True
+            continue
+
+        report = {
+            'mcu': mcu,
+            'commit': commit,
+            'dirty': dirty,
+            'config': config,
+            'results': results,
+        }
+
+        path = os.path.join(args.output_dir, 'bench-%s-%s.json' % (mcu, (commit or 'unknown')[:10]))
+        with open(path, 'w') as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+            f.write('\n')
+        print('%s: wrote %s' % (mcu, path))
+
+        if args.compare:
+            with open(args.compare) as f:
+                compare(report, json.load(f))
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())